@@ -0,0 +1,431 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Shared benchmark harness for the standalone demos. Each program keeps its own `--bench` entry point
+// and human-readable output; this header adds what is needed to compare runs between releases:
+//
+//   * Reproducible workloads: makeKeys() builds the key sequences the benchmarks are asked to cover
+//     (uniform, sorted, reversed, Zipf-skewed, few distinct values) from an explicit seed, and Rng
+//     draws any other workload (bounded integers, reals, shuffles) the same way on every platform.
+//   * Hot-path counters: DSA_COUNT("name", amount) at an instrumented site adds to a named global
+//     counter. It compiles to nothing unless the program is built with -DDSA_COUNTERS, so the timed
+//     build pays nothing; build a second binary with counters on to see, for example, how many slots a
+//     lookup probes on average.
+//   * A JSON report: Suite runs each benchmark as a named case, records its wall time, any metrics
+//     the benchmark reports via record(), and the counter totals the case produced, and with
+//     `--json path` writes them all as one JSON document.
+//
+// Command line, after `--bench`:  [--json path] [--filter substring] [--repeat n]
+// --repeat runs each case n times and reports the minimum and median wall time; metrics and counters
+// come from the last repetition.
+
+namespace bench {
+
+constexpr std::uint64_t kDefaultSeed = 20240601;
+
+// ---- Workloads ------------------------------------------------------------------------------------
+
+enum class Distribution {
+    Uniform,    // Independent uniform draws from [0, 2^30).
+    Sorted,     // 0, 1, 2, ...: the append-in-order case that degrades unbalanced trees.
+    Reversed,   // n-1, n-2, ..., 0.
+    Zipf,       // Rank r drawn with probability proportional to 1/r (s = 1), over n distinct keys.
+    FewUnique   // Uniform over only 16 distinct keys, for duplicate-heavy paths.
+};
+
+inline const char* distributionName(Distribution distribution) {
+    switch (distribution) {
+        case Distribution::Uniform:
+            return "uniform";
+        case Distribution::Sorted:
+            return "sorted";
+        case Distribution::Reversed:
+            return "reversed";
+        case Distribution::Zipf:
+            return "zipf";
+        case Distribution::FewUnique:
+            return "few_unique";
+    }
+    return "unknown";
+}
+
+// Same arguments, same keys, on every platform: the generator is mt19937_64 and the distributions are
+// computed here rather than with <random>'s implementation-defined distribution classes.
+inline std::vector<int> makeKeys(Distribution distribution, std::size_t count, std::uint64_t seed = kDefaultSeed) {
+    std::vector<int> keys(count);
+    std::mt19937_64 rng(seed);
+    switch (distribution) {
+        case Distribution::Uniform:
+            for (int& key : keys) {
+                key = static_cast<int>(rng() >> 34);
+            }
+            break;
+        case Distribution::Sorted:
+            std::iota(keys.begin(), keys.end(), 0);
+            break;
+        case Distribution::Reversed:
+            for (std::size_t i = 0; i < count; ++i) {
+                keys[i] = static_cast<int>(count - 1 - i);
+            }
+            break;
+        case Distribution::Zipf: {
+            // Inverse-CDF sampling over a precomputed table of cumulative 1/r weights.
+            std::vector<double> cumulative(std::max<std::size_t>(count, 1));
+            double total = 0;
+            for (std::size_t rank = 0; rank < cumulative.size(); ++rank) {
+                total += 1.0 / static_cast<double>(rank + 1);
+                cumulative[rank] = total;
+            }
+            for (int& key : keys) {
+                double target = static_cast<double>(rng() >> 11) * 0x1.0p-53 * total;
+                key = static_cast<int>(std::lower_bound(cumulative.begin(), cumulative.end(), target) -
+                                       cumulative.begin());
+            }
+            break;
+        }
+        case Distribution::FewUnique:
+            for (int& key : keys) {
+                key = static_cast<int>(rng() >> 60);
+            }
+            break;
+    }
+    return keys;
+}
+
+// Seeded generator for workloads makeKeys() does not cover. mt19937_64's output is fixed by the standard
+// but <random>'s distribution classes and std::shuffle are not, so every draw below is computed here.
+class Rng {
+public:
+    explicit Rng(std::uint64_t seed = kDefaultSeed) : engine(seed) {}
+
+    std::uint64_t next() {
+        return engine();
+    }
+
+    // Uniform over [0, bound), bound > 0. Benchmarks call this inside timed loops, so 32-bit bounds use
+    // Lemire's multiply-shift mapping, which needs a division only on the rare draws it might reject.
+    std::uint64_t below(std::uint64_t bound) {
+        if (bound <= std::numeric_limits<std::uint32_t>::max()) {
+            std::uint64_t product = (engine() >> 32) * bound;
+            if (static_cast<std::uint32_t>(product) < bound) {
+                std::uint32_t threshold = static_cast<std::uint32_t>(0 - bound) % static_cast<std::uint32_t>(bound);
+                while (static_cast<std::uint32_t>(product) < threshold) {
+                    product = (engine() >> 32) * bound;
+                }
+            }
+            return product >> 32;
+        }
+        // Wider bounds reject draws from the biased top residue.
+        const std::uint64_t top = std::numeric_limits<std::uint64_t>::max();
+        std::uint64_t limit = top - top % bound;
+        std::uint64_t draw;
+        do {
+            draw = engine();
+        } while (draw >= limit);
+        return draw % bound;
+    }
+
+    // Uniform over the closed range [low, high].
+    int between(int low, int high) {
+        std::uint64_t span = static_cast<std::uint64_t>(static_cast<std::int64_t>(high) - low) + 1;
+        return static_cast<int>(static_cast<std::int64_t>(low) + static_cast<std::int64_t>(below(span)));
+    }
+
+    // Uniform over [0, 1) from the top 53 bits, i.e. every double the interval can represent evenly.
+    double unit() {
+        return static_cast<double>(engine() >> 11) * 0x1.0p-53;
+    }
+
+    double between(double low, double high) {
+        return low + (high - low) * unit();
+    }
+
+    // Standard normal by the Box-Muller transform.
+    double normal() {
+        double radius = std::sqrt(-2.0 * std::log(1.0 - unit()));
+        return radius * std::cos(6.283185307179586 * unit());
+    }
+
+    // Fisher-Yates, walking from the back as std::shuffle implementations usually do.
+    template <typename T>
+    void shuffle(std::vector<T>& values) {
+        for (std::size_t i = values.size(); i > 1; --i) {
+            std::swap(values[i - 1], values[below(i)]);
+        }
+    }
+
+private:
+    std::mt19937_64 engine;
+};
+
+// ---- Counters -------------------------------------------------------------------------------------
+
+// One named event counter. Increments are relaxed atomics so instrumented multi-threaded code stays
+// correct; they do contend, which is acceptable because timings are taken from uninstrumented builds.
+class Counter {
+public:
+    explicit Counter(std::string counterName) : counterName(std::move(counterName)) {}
+
+    void add(std::uint64_t amount) {
+        total.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    std::uint64_t value() const {
+        return total.load(std::memory_order_relaxed);
+    }
+
+    void reset() {
+        total.store(0, std::memory_order_relaxed);
+    }
+
+    const std::string& name() const {
+        return counterName;
+    }
+
+private:
+    std::string counterName;
+    std::atomic<std::uint64_t> total{0};
+};
+
+class CounterRegistry {
+public:
+    static CounterRegistry& instance() {
+        static CounterRegistry registry;
+        return registry;
+    }
+
+    // Returns the counter with this name, creating it on first use. References stay valid for the life
+    // of the program (a deque never moves its elements), so call sites cache them in a static.
+    Counter& get(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Counter& counter : counters) {
+            if (counter.name() == name) {
+                return counter;
+            }
+        }
+        counters.emplace_back(name);
+        return counters.back();
+    }
+
+    void resetAll() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Counter& counter : counters) {
+            counter.reset();
+        }
+    }
+
+    // Counters that fired since the last reset, for reporting.
+    std::vector<std::pair<std::string, std::uint64_t>> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::pair<std::string, std::uint64_t>> values;
+        for (const Counter& counter : counters) {
+            if (counter.value() != 0) {
+                values.emplace_back(counter.name(), counter.value());
+            }
+        }
+        return values;
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<Counter> counters;
+};
+
+#if defined(DSA_COUNTERS)
+constexpr bool kCountersEnabled = true;
+#define DSA_COUNT(name, amount)                                                                    \
+    do {                                                                                           \
+        static ::bench::Counter& dsaCounter = ::bench::CounterRegistry::instance().get(name);     \
+        dsaCounter.add(static_cast<std::uint64_t>(amount));                                        \
+    } while (0)
+#else
+constexpr bool kCountersEnabled = false;
+#define DSA_COUNT(name, amount) \
+    do {                        \
+    } while (0)
+#endif
+
+// ---- Report ---------------------------------------------------------------------------------------
+
+inline std::string jsonString(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"':
+                quoted += "\\\"";
+                break;
+            case '\\':
+                quoted += "\\\\";
+                break;
+            case '\n':
+                quoted += "\\n";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    quoted += escaped;
+                } else {
+                    quoted += c;
+                }
+        }
+    }
+    return quoted + "\"";
+}
+
+// JSON has no NaN or infinity; those become null.
+inline std::string jsonNumber(double value) {
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.6g", value);
+    return text;
+}
+
+struct CaseResult {
+    std::string name;
+    std::vector<double> wallMs;
+    std::vector<std::pair<std::string, double>> metrics;
+    std::vector<std::pair<std::string, std::uint64_t>> counters;
+};
+
+// The case currently running, so benchmark code can report metrics without threading a handle through.
+inline CaseResult*& currentCase() {
+    static CaseResult* running = nullptr;
+    return running;
+}
+
+// Attaches a named metric (ns per op, Mops/s, a percentile, ...) to the running case. A no-op outside a
+// Suite, so benchmark functions can call it unconditionally.
+inline void record(const std::string& metric, double value) {
+    if (CaseResult* running = currentCase()) {
+        for (auto& entry : running->metrics) {
+            if (entry.first == metric) {
+                entry.second = value;
+                return;
+            }
+        }
+        running->metrics.emplace_back(metric, value);
+    }
+}
+
+class Suite {
+public:
+    // Parses the harness flags that follow `--bench`; unknown arguments are left for the program.
+    Suite(std::string suiteName, int argc, char* argv[]) : suiteName(std::move(suiteName)) {
+        for (int i = 1; i < argc; ++i) {
+            std::string argument = argv[i];
+            if (argument == "--json" && i + 1 < argc) {
+                jsonPath = argv[++i];
+            } else if (argument == "--filter" && i + 1 < argc) {
+                filter = argv[++i];
+            } else if (argument == "--repeat" && i + 1 < argc) {
+                repeat = std::max(1, std::atoi(argv[++i]));
+            }
+        }
+    }
+
+    Suite(const Suite&) = delete;
+    Suite& operator=(const Suite&) = delete;
+
+    // Runs one case unless --filter excludes it.
+    void run(const std::string& caseName, const std::function<void()>& body) {
+        if (!filter.empty() && caseName.find(filter) == std::string::npos) {
+            return;
+        }
+        results.push_back(CaseResult{caseName, {}, {}, {}});
+        CaseResult& result = results.back();
+        currentCase() = &result;
+        for (int i = 0; i < repeat; ++i) {
+            CounterRegistry::instance().resetAll();
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto end = std::chrono::steady_clock::now();
+            result.wallMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        currentCase() = nullptr;
+        result.counters = CounterRegistry::instance().snapshot();
+    }
+
+    // Writes the JSON report if one was requested; returns the process exit code.
+    int finish() const {
+        if (jsonPath.empty()) {
+            return 0;
+        }
+        std::ofstream out(jsonPath);
+        if (!out) {
+            std::cerr << "Cannot write benchmark report " << jsonPath << "\n";
+            return 1;
+        }
+        writeJson(out);
+        return out ? 0 : 1;
+    }
+
+    void writeJson(std::ostream& out) const {
+        out << "{\n  \"suite\": " << jsonString(suiteName) << ",\n";
+        out << "  \"compiler\": " << jsonString(compilerName()) << ",\n";
+        out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+        out << "  \"counters_enabled\": " << (kCountersEnabled ? "true" : "false") << ",\n";
+        out << "  \"repeat\": " << repeat << ",\n  \"cases\": [";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const CaseResult& result = results[i];
+            std::vector<double> sorted = result.wallMs;
+            std::sort(sorted.begin(), sorted.end());
+            out << (i ? ",\n" : "\n") << "    {\"name\": " << jsonString(result.name)
+                << ", \"wall_ms_min\": " << jsonNumber(sorted.front())
+                << ", \"wall_ms_median\": " << jsonNumber(sorted[sorted.size() / 2]) << ",\n     \"metrics\": {";
+            for (std::size_t m = 0; m < result.metrics.size(); ++m) {
+                out << (m ? ", " : "") << jsonString(result.metrics[m].first) << ": "
+                    << jsonNumber(result.metrics[m].second);
+            }
+            out << "},\n     \"counters\": {";
+            for (std::size_t c = 0; c < result.counters.size(); ++c) {
+                out << (c ? ", " : "") << jsonString(result.counters[c].first) << ": " << result.counters[c].second;
+            }
+            out << "}}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+private:
+    std::string suiteName;
+    std::string jsonPath;
+    std::string filter;
+    int repeat = 1;
+    std::deque<CaseResult> results;
+
+    static std::string compilerName() {
+#if defined(__clang__)
+        return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+        return std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc " + std::to_string(_MSC_VER);
+#else
+        return "unknown";
+#endif
+    }
+};
+
+}  // namespace bench
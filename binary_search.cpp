@@ -1,19 +1,92 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
+#include <string>
 #include <vector>
 
+#include "bench_harness.h"
+#include "cache_aligned_allocator.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 // This program illustrates binary search, a logarithmic-time algorithm for finding a
 // target value inside a sorted array. We implement both iterative and recursive variants.
 // Binary search repeatedly halves the search interval, using the array's ordering to decide
 // which half might contain the target while discarding the other half.
+//
+// On large arrays the textbook loop is limited by two things: the branch on every level, which is
+// unpredictable for random targets, and the cache miss on every level, which the CPU cannot start
+// early because the next address depends on the current comparison. branchlessLowerBound removes the
+// branch, EytzingerIndex lays the array out in breadth-first order so the next few levels of a search
+// share cache lines and can be prefetched, and searchMany interleaves many independent searches so
+// their misses overlap instead of queuing one after another. StaticBTree goes one step further and
+// groups 16 keys per cache-line node, searched with a single SIMD comparison, so a lookup reads only
+// log17(n) lines.
+
+// Asks the cache to start loading address early; a no-op on compilers without the builtin.
+inline void prefetchLine(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
 
-int binarySearchIterative(const std::vector<int>& data, int target) {
+// Number of trailing 1 bits of value (value must not be all ones).
+inline unsigned trailingOnes(unsigned long long value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(~value));
+#else
+    unsigned ones = 0;
+    while (value & 1ULL) {
+        value >>= 1;
+        ++ones;
+    }
+    return ones;
+#endif
+}
+
+// Index of the highest set bit of a nonzero value.
+inline unsigned highestBit(unsigned long long value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(63 - __builtin_clzll(value));
+#else
+    unsigned bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+// Number of set bits in value.
+inline unsigned bitCount(unsigned value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_popcount(value));
+#else
+    unsigned bits = 0;
+    for (; value != 0; value &= value - 1) {
+        ++bits;
+    }
+    return bits;
+#endif
+}
+
+std::ptrdiff_t binarySearchIterative(const std::vector<int>& data, int target) {
     // The window [left, right] captures the portion of the sorted vector that may still
     // contain the target. Shrinking this interval logarithmically gives O(log n) runtime.
-    int left = 0;
-    int right = static_cast<int>(data.size()) - 1;
+    // Signed pointer-sized indices reach past 2^31 elements and still let right drop to -1.
+    std::ptrdiff_t left = 0;
+    std::ptrdiff_t right = static_cast<std::ptrdiff_t>(data.size()) - 1;
     while (left <= right) {
         // Choosing the midpoint with the overflow-safe formula keeps the search balanced.
-        int mid = left + (right - left) / 2;
+        std::ptrdiff_t mid = left + (right - left) / 2;
         if (data[mid] == target) {
             return mid;
         }
@@ -28,13 +101,14 @@ int binarySearchIterative(const std::vector<int>& data, int target) {
     return -1;
 }
 
-int binarySearchRecursive(const std::vector<int>& data, int target, int left, int right) {
+std::ptrdiff_t binarySearchRecursive(const std::vector<int>& data, int target, std::ptrdiff_t left,
+                                     std::ptrdiff_t right) {
     // When the interval becomes empty, the value was not found anywhere in the array.
     if (left > right) {
         return -1;
     }
     // Midpoint selection mirrors the iterative routine so both variants share behavior.
-    int mid = left + (right - left) / 2;
+    std::ptrdiff_t mid = left + (right - left) / 2;
     if (data[mid] == target) {
         return mid;
     }
@@ -46,15 +120,386 @@ int binarySearchRecursive(const std::vector<int>& data, int target, int left, in
     return binarySearchRecursive(data, target, left, mid - 1);
 }
 
-int main() {
+// Returns the index of the first element that is not less than target (data.size() if there is none),
+// like std::lower_bound. The window only ever shrinks by half its length, and whether its base moves is
+// a conditional move rather than a branch, so the loop runs exactly ceil(log2 n) iterations with
+// nothing for the branch predictor to get wrong.
+std::size_t branchlessLowerBound(const std::vector<int>& data, int target) {
+    std::size_t length = data.size();
+    if (length == 0) {
+        return 0;
+    }
+    const int* base = data.data();
+    while (length > 1) {
+        std::size_t half = length / 2;
+        // Both possible probes of the next iteration are known now (give or take the neighbouring
+        // element); fetching them early overlaps the next miss with this one, at the price of one
+        // wasted line per level.
+        std::size_t nextHalf = (length - half) / 2;
+        prefetchLine(base + nextHalf);
+        prefetchLine(base + half + nextHalf);
+        base = base[half - 1] < target ? base + half : base;
+        length -= half;
+    }
+    return static_cast<std::size_t>(base - data.data()) + (*base < target);
+}
+
+// Search index over a sorted array in Eytzinger (breadth-first) order: node k has children 2k and
+// 2k + 1, so the root and the first levels every search passes through sit together at the front, and
+// the 16 descendants four levels below node k are one 64-byte line starting at 16k. The array is padded
+// with INT_MAX up to a complete tree of 2^levels - 1 nodes, which costs at most 2x the memory but gives
+// every search exactly the same number of steps. That makes lookups easy to interleave and lets the
+// in-order position of a node be computed from its index instead of stored.
+class EytzingerIndex {
+public:
+    explicit EytzingerIndex(const std::vector<int>& sorted) : count(sorted.size()) {
+        while ((std::size_t(1) << levels) - 1 < count) {
+            ++levels;
+        }
+        std::size_t nodeCount = (std::size_t(1) << levels) - 1;
+        // Node 0 is unused, so node 16k, the first of each block of 16 descendants, starts a cache line.
+        storage.assign(nodeCount + 1, INT_MAX);
+        std::size_t next = 0;
+        fill(sorted, 1, nodeCount, next);
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    // Same result as branchlessLowerBound on the original sorted array.
+    std::size_t lowerBound(int target) const {
+        const int* tree = nodes();
+        std::size_t k = 1;
+        for (unsigned level = 0; level < levels; ++level) {
+            // Four levels ahead, all 16 possible descendants share one cache line; fetching it now
+            // overlaps that miss with the next four comparisons.
+            prefetchLine(tree + std::min(k * kLineInts, lastNode()));
+            k = 2 * k + (tree[k] < target);
+        }
+        return positionOf(k);
+    }
+
+    // Batched lookup: results[i] = lowerBound(queries[i]). Searches advance in groups of kBatch, one
+    // level at a time for the whole group, so up to kBatch independent cache misses are in flight at
+    // once; each step prefetches the node that query will read one round later.
+    void searchMany(const int* queries, std::size_t queryCount, std::size_t* results) const {
+        const int* tree = nodes();
+        std::size_t k[kBatch];
+        for (std::size_t first = 0; first < queryCount; first += kBatch) {
+            const std::size_t group = std::min(kBatch, queryCount - first);
+            const int* batch = queries + first;
+            for (std::size_t i = 0; i < group; ++i) {
+                k[i] = 1;
+            }
+            for (unsigned level = 0; level < levels; ++level) {
+                for (std::size_t i = 0; i < group; ++i) {
+                    k[i] = 2 * k[i] + (tree[k[i]] < batch[i]);
+                    prefetchLine(tree + std::min(k[i], lastNode()));
+                }
+            }
+            for (std::size_t i = 0; i < group; ++i) {
+                results[first + i] = positionOf(k[i]);
+            }
+        }
+    }
+
+    std::vector<std::size_t> searchMany(const std::vector<int>& queries) const {
+        std::vector<std::size_t> results(queries.size());
+        searchMany(queries.data(), queries.size(), results.data());
+        return results;
+    }
+
+private:
+    static constexpr std::size_t kLineInts = 64 / sizeof(int);
+    static constexpr std::size_t kBatch = 16;
+
+    // 64-byte aligned in every copy, so the blocks of 16 descendants each stay on one cache line.
+    std::vector<int, CacheAlignedAllocator<int>> storage;
+    std::size_t count;
+    unsigned levels = 0;
+
+    const int* nodes() const {
+        return storage.data();
+    }
+
+    // Prefetch addresses are clamped to the last node so they always point inside storage.
+    std::size_t lastNode() const {
+        return (std::size_t(1) << levels) - 1;
+    }
+
+    // In-order traversal of the implicit tree hands out the sorted values in order; padding nodes
+    // past the end keep INT_MAX.
+    void fill(const std::vector<int>& sorted, std::size_t k, std::size_t nodeCount, std::size_t& next) {
+        if (k > nodeCount) {
+            return;
+        }
+        fill(sorted, 2 * k, nodeCount, next);
+        if (next < sorted.size()) {
+            storage[k] = sorted[next];
+        }
+        ++next;
+        fill(sorted, 2 * k + 1, nodeCount, next);
+    }
+
+    // After the last level, k's path records left turns as 0 bits and right turns as 1 bits. The
+    // answer is the last node where the search went left, found by shifting off the trailing 1s and
+    // the 0 before them; k == 0 means it never went left, so every value is smaller than the target.
+    // In a complete tree of the given height the in-order position of node k at depth d is
+    // (2 (k - 2^d) + 1) 2^(levels - 1 - d) - 1; positions past the real elements are padding.
+    std::size_t positionOf(std::size_t k) const {
+        k >>= trailingOnes(k) + 1;
+        if (k == 0) {
+            return count;
+        }
+        unsigned depth = highestBit(k);
+        std::size_t position = ((2 * (k - (std::size_t(1) << depth)) + 1) << (levels - 1 - depth)) - 1;
+        return std::min(position, count);
+    }
+};
+
+// Static B+-tree (an "S+ tree") over a sorted array, built once and then only queried. Every node is 16
+// ints, exactly one 64-byte cache line, so a lookup costs one line per level and the tree is only
+// log17(n) levels deep: 1M keys take 5 lines, a billion 8. The leaf layer is the sorted array itself
+// (padded with INT_MAX to whole nodes), so a search ends at the element's position in the original
+// array and no position table is needed. Key j of an internal node is the smallest key under child
+// j + 1, which makes the number of node keys below the target exactly the child to descend into.
+// That count is one SIMD compare and a movemask popcount with AVX2, and a short loop otherwise.
+class StaticBTree {
+public:
+    explicit StaticBTree(const std::vector<int>& sorted) : count(sorted.size()) {
+        std::vector<std::size_t> layerNodes = {std::max<std::size_t>((count + kNodeKeys - 1) / kNodeKeys, 1)};
+        while (layerNodes.back() > 1) {
+            layerNodes.push_back((layerNodes.back() + kNodeKeys) / (kNodeKeys + 1));
+        }
+        std::size_t totalNodes = 0;
+        for (std::size_t nodes : layerNodes) {
+            layerStart.push_back(totalNodes * kNodeKeys);
+            totalNodes += nodes;
+        }
+        storage.assign(totalNodes * kNodeKeys, INT_MAX);
+        std::copy(sorted.begin(), sorted.end(), storage.begin());
+
+        // Child c of node k on layer h is node k * 17 + c on layer h - 1, so the leftmost leaf below a
+        // layer-h node is its index times 17^h.
+        std::size_t span = 1;
+        for (std::size_t layer = 1; layer < layerNodes.size(); ++layer) {
+            for (std::size_t node = 0; node < layerNodes[layer]; ++node) {
+                for (std::size_t key = 0; key < kNodeKeys; ++key) {
+                    std::size_t leaf = (node * (kNodeKeys + 1) + key + 1) * span;
+                    if (leaf < layerNodes[0]) {
+                        storage[layerStart[layer] + node * kNodeKeys + key] = storage[leaf * kNodeKeys];
+                    }
+                }
+            }
+            span *= kNodeKeys + 1;
+        }
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    // Index of the first element not less than target, as std::lower_bound would return.
+    std::size_t lowerBound(int target) const {
+        const int* nodes = storage.data();
+        std::size_t node = 0;
+        for (std::size_t layer = layerStart.size() - 1; layer > 0; --layer) {
+            node = node * (kNodeKeys + 1) + keysBelow(nodes + layerStart[layer] + node * kNodeKeys, target);
+        }
+        std::size_t position = node * kNodeKeys + keysBelow(nodes + node * kNodeKeys, target);
+        return std::min(position, count);
+    }
+
+    bool contains(int target) const {
+        std::size_t position = lowerBound(target);
+        return position < count && storage[position] == target;
+    }
+
+    // Drop-in replacement for binarySearchIterative: the index of target in the original array, or -1.
+    // With duplicate keys this is the first occurrence, where bisection may land on any of them.
+    std::ptrdiff_t find(int target) const {
+        std::size_t position = lowerBound(target);
+        return position < count && storage[position] == target ? static_cast<std::ptrdiff_t>(position) : -1;
+    }
+
+    // Number of elements with low <= value <= high.
+    std::size_t countInRange(int low, int high) const {
+        if (low > high) {
+            return 0;
+        }
+        std::size_t end = high == INT_MAX ? count : lowerBound(high + 1);
+        return end - lowerBound(low);
+    }
+
+private:
+    static constexpr std::size_t kNodeKeys = 16;
+
+    // 64-byte aligned, so every node is one cache line and keysBelow's aligned loads are valid in copies.
+    std::vector<int, CacheAlignedAllocator<int>> storage;
+    std::vector<std::size_t> layerStart; // First key of each layer in storage; layer 0 is the leaves.
+    std::size_t count;
+
+    // Number of keys in a sorted 16-key node that are less than target.
+    static std::size_t keysBelow(const int* node, int target) {
+#if defined(__AVX2__)
+        const __m256i wanted = _mm256_set1_epi32(target);
+        __m256i low = _mm256_cmpgt_epi32(wanted, _mm256_load_si256(reinterpret_cast<const __m256i*>(node)));
+        __m256i high = _mm256_cmpgt_epi32(wanted, _mm256_load_si256(reinterpret_cast<const __m256i*>(node + 8)));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(low))) |
+                        static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(high))) << 8;
+        return bitCount(mask);
+#else
+        // A fixed-length count with no early exit; compilers vectorize it with whatever SIMD the target has.
+        std::size_t below = 0;
+        for (std::size_t key = 0; key < kNodeKeys; ++key) {
+            below += node[key] < target;
+        }
+        return below;
+#endif
+    }
+};
+
+// Times the lower-bound variants on an array well beyond the last-level cache with random targets.
+void runSearchBenchmark() {
+    const std::size_t count = (1 << 23) + 12345;
+    const std::size_t queryCount = 1 << 22;
+    std::vector<int> sorted = bench::makeKeys(bench::Distribution::Uniform, count, 47);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<int> queries = bench::makeKeys(bench::Distribution::Uniform, queryCount, 48);
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    auto time = [&](const char* name, auto search) {
+        auto start = std::chrono::steady_clock::now();
+        std::size_t checksum = search();
+        auto end = std::chrono::steady_clock::now();
+        std::cout << "  " << name << " " << ms(start, end) << " ms (checksum " << checksum << ")\n";
+        bench::record(std::string(name) + " ns/query",
+                      std::chrono::duration<double, std::nano>(end - start).count() / queryCount);
+    };
+    std::cout << "Search benchmark: " << queryCount << " lower bounds in " << count << " ints\n";
+    time("std::lower_bound", [&] {
+        std::size_t sum = 0;
+        for (int query : queries) {
+            sum += static_cast<std::size_t>(std::lower_bound(sorted.begin(), sorted.end(), query) - sorted.begin());
+        }
+        return sum;
+    });
+    time("branchlessLowerBound", [&] {
+        std::size_t sum = 0;
+        for (int query : queries) {
+            sum += branchlessLowerBound(sorted, query);
+        }
+        return sum;
+    });
+    EytzingerIndex index(sorted);
+    time("EytzingerIndex::lowerBound", [&] {
+        std::size_t sum = 0;
+        for (int query : queries) {
+            sum += index.lowerBound(query);
+        }
+        return sum;
+    });
+    time("EytzingerIndex::searchMany", [&] {
+        std::vector<std::size_t> results = index.searchMany(queries);
+        std::size_t sum = 0;
+        for (std::size_t result : results) {
+            sum += result;
+        }
+        return sum;
+    });
+}
+
+// Exact-match lookups (about half of them hits) at sizes from 1K keys up to 64M keys (256 MiB), reported
+// as nanoseconds per query. Keys are the odd numbers 1, 3, 5, ..., so every variant agrees on the index.
+void runIndexBenchmark() {
+    const std::size_t queryCount = 1 << 21;
+    std::cout << "Index benchmark: ns per find, " << queryCount << " random queries\n"
+              << "  keys         iterative  recursive  Eytzinger StaticBTree\n";
+    bench::Rng rng(53);
+    const char* variantNames[4] = {"iterative", "recursive", "Eytzinger", "StaticBTree"};
+    for (std::size_t count : {std::size_t(1) << 10, std::size_t(1) << 16, std::size_t(1) << 20, std::size_t(1) << 24,
+                              std::size_t(1) << 26}) {
+        std::vector<int> sorted(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            sorted[i] = static_cast<int>(2 * i + 1);
+        }
+        std::vector<int> queries(queryCount);
+        for (int& query : queries) {
+            query = static_cast<int>(rng.below(2 * count + 1));
+        }
+        EytzingerIndex eytzinger(sorted);
+        StaticBTree tree(sorted);
+        std::ptrdiff_t checksums[4] = {0, 0, 0, 0};
+        double nanoseconds[4];
+        auto time = [&](int variant, auto find) {
+            auto start = std::chrono::steady_clock::now();
+            std::ptrdiff_t sum = 0;
+            for (int query : queries) {
+                sum += find(query);
+            }
+            auto end = std::chrono::steady_clock::now();
+            checksums[variant] = sum;
+            nanoseconds[variant] = std::chrono::duration<double, std::nano>(end - start).count() / queryCount;
+        };
+        time(0, [&](int query) { return binarySearchIterative(sorted, query); });
+        time(1, [&](int query) {
+            return binarySearchRecursive(sorted, query, 0, static_cast<std::ptrdiff_t>(sorted.size()) - 1);
+        });
+        time(2, [&](int query) {
+            std::size_t position = eytzinger.lowerBound(query);
+            return position < count && sorted[position] == query ? static_cast<std::ptrdiff_t>(position) : -1;
+        });
+        time(3, [&](int query) { return tree.find(query); });
+        bool agree = checksums[0] == checksums[1] && checksums[1] == checksums[2] && checksums[2] == checksums[3];
+        std::cout << "  " << std::left << std::setw(10) << count << std::right << std::fixed << std::setprecision(1);
+        for (int variant = 0; variant < 4; ++variant) {
+            std::cout << std::setw(11) << nanoseconds[variant];
+            bench::record(std::string(variantNames[variant]) + " " + std::to_string(count) + " keys ns/find",
+                          nanoseconds[variant]);
+        }
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << (agree ? "" : "  (results DIFFER)") << "\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("binary_search", argc, argv);
+        suite.run("search", runSearchBenchmark);
+        suite.run("index", runIndexBenchmark);
+        return suite.finish();
+    }
+
     std::vector<int> sorted = {1, 3, 5, 7, 9, 11, 13, 15};
 
     // Demonstrate that both implementations return matching positions for present values
     // and -1 when the searched key is missing.
     std::cout << "Iterative search for 7: index " << binarySearchIterative(sorted, 7) << "\n";
     std::cout << "Recursive search for 11: index "
-              << binarySearchRecursive(sorted, 11, 0, static_cast<int>(sorted.size()) - 1) << "\n";
+              << binarySearchRecursive(sorted, 11, 0, static_cast<std::ptrdiff_t>(sorted.size()) - 1) << "\n";
     std::cout << "Search for missing value 4: index " << binarySearchIterative(sorted, 4) << "\n";
 
+    // The lower-bound searches report where a value is or would be inserted.
+    EytzingerIndex index(sorted);
+    std::cout << "Lower bound of 4: branchless " << branchlessLowerBound(sorted, 4) << ", Eytzinger "
+              << index.lowerBound(4) << "\n";
+    std::vector<std::size_t> many = index.searchMany({0, 7, 8, 16});
+    std::cout << "Batched lower bounds of 0, 7, 8, 16:";
+    for (std::size_t position : many) {
+        std::cout << ' ' << position;
+    }
+    std::cout << "\n";
+
+    // The B+-tree answers the same questions from cache-line-sized nodes.
+    StaticBTree tree(sorted);
+    std::cout << "StaticBTree: find(11) " << tree.find(11) << ", contains(4) " << std::boolalpha << tree.contains(4)
+              << ", values in [4, 12]: " << tree.countInRange(4, 12) << "\n";
+    // Copies get their own aligned storage, so the SIMD node search stays valid in them.
+    StaticBTree copy = tree;
+    StaticBTree assigned(std::vector<int>{2, 4});
+    assigned = tree;
+    std::cout << "Copied StaticBTree: lowerBound(8) " << copy.lowerBound(8) << ", assigned copy find(13) "
+              << assigned.find(13) << "\n";
+
     return 0;
 }
@@ -1,5 +1,17 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <new>
 #include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench_harness.h"
 
 // This program implements a basic Binary Search Tree (BST) that stores unique keys.
 // Each node keeps pointers to its left and right children. The BST property guarantees the
@@ -154,7 +166,455 @@ private:
     }
 };
 
-int main() {
+// Fixed-size object pool for tree nodes. Nodes are carved out of blocks of kBlockNodes slots, so a tree
+// of a million keys makes a few hundred allocations instead of a million, neighbouring inserts land on
+// neighbouring cache lines, and freed slots go onto an intrusive free list for the next insert to reuse.
+// The pool never returns memory to the system before it is destroyed.
+template <typename T>
+class NodePool {
+public:
+    NodePool() = default;
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        if (!freeList) {
+            grow();
+        }
+        Slot* slot = freeList;
+        freeList = slot->next;
+        return new (slot->storage) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T* object) {
+        object->~T();
+        Slot* slot = reinterpret_cast<Slot*>(object);
+        slot->next = freeList;
+        freeList = slot;
+    }
+
+private:
+    // A free slot holds the free-list link; a live slot holds the object.
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static constexpr std::size_t kBlockNodes = 1024;
+
+    std::vector<std::unique_ptr<Slot[]>> blocks;
+    Slot* freeList = nullptr;
+
+    void grow() {
+        blocks.emplace_back(new Slot[kBlockNodes]);
+        Slot* block = blocks.back().get();
+        // Thread the new slots in address order so consecutive creates walk forward through memory.
+        for (std::size_t i = kBlockNodes; i-- > 0;) {
+            block[i].next = freeList;
+            freeList = &block[i];
+        }
+    }
+};
+
+// Ordered map on an AVL tree: the heights of every node's two subtrees differ by at most one, so the
+// tree stays within 1.44 log2(n) levels whatever the insertion order. Keys inserted in sorted order,
+// which turn BinarySearchTree into a linked list, produce a perfectly shaped tree here.
+//
+// Every operation is iterative. Nodes carry a parent pointer, so insert and erase walk back up from the
+// change to restore balance, and iterators step to the in-order successor without a stack. Nodes come
+// from a NodePool, and erase relinks nodes instead of moving keys between them, so iterators and
+// references to other elements stay valid, as with std::map.
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+class AvlMap {
+    struct Node;
+
+public:
+    using value_type = std::pair<const Key, Value>;
+
+    class iterator {
+    public:
+        iterator() = default;
+
+        value_type& operator*() const {
+            return node->entry;
+        }
+
+        value_type* operator->() const {
+            return &node->entry;
+        }
+
+        // In-order successor: the leftmost node of the right subtree, or else the first ancestor that
+        // is reached from its left side.
+        iterator& operator++() {
+            if (node->right) {
+                node = leftmost(node->right);
+            } else {
+                Node* child = node;
+                node = node->parent;
+                while (node && child == node->right) {
+                    child = node;
+                    node = node->parent;
+                }
+            }
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const {
+            return node == other.node;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return node != other.node;
+        }
+
+    private:
+        friend class AvlMap;
+        explicit iterator(Node* at) : node(at) {}
+        Node* node = nullptr;
+    };
+
+    // Half-open slice of the map, usable in a range-based for loop.
+    struct Range {
+        iterator first;
+        iterator last;
+
+        iterator begin() const {
+            return first;
+        }
+
+        iterator end() const {
+            return last;
+        }
+    };
+
+    explicit AvlMap(Compare comparator = Compare()) : compare(comparator) {}
+
+    ~AvlMap() {
+        clear();
+    }
+
+    AvlMap(const AvlMap&) = delete;
+    AvlMap& operator=(const AvlMap&) = delete;
+
+    std::size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    // Number of levels; 0 for an empty map.
+    int height() const {
+        return heightOf(root);
+    }
+
+    iterator begin() const {
+        return iterator(root ? leftmost(root) : nullptr);
+    }
+
+    iterator end() const {
+        return iterator(nullptr);
+    }
+
+    // Inserts key -> value unless key is already present. Returns the element with that key and whether
+    // it was inserted, like std::map::insert.
+    std::pair<iterator, bool> insert(const Key& key, Value value) {
+        Node* parent = nullptr;
+        Node** link = &root;
+        while (*link) {
+            parent = *link;
+            if (compare(key, parent->entry.first)) {
+                link = &parent->left;
+            } else if (compare(parent->entry.first, key)) {
+                link = &parent->right;
+            } else {
+                return {iterator(parent), false};
+            }
+        }
+        Node* node = pool.create(key, std::move(value), parent);
+        *link = node;
+        ++count;
+        rebalanceFrom(parent);
+        return {iterator(node), true};
+    }
+
+    iterator find(const Key& key) const {
+        iterator candidate = lowerBound(key);
+        return candidate != end() && !compare(key, candidate->first) ? candidate : end();
+    }
+
+    bool contains(const Key& key) const {
+        return find(key) != end();
+    }
+
+    // First element whose key is not less than key.
+    iterator lowerBound(const Key& key) const {
+        Node* node = root;
+        Node* best = nullptr;
+        while (node) {
+            if (compare(node->entry.first, key)) {
+                node = node->right;
+            } else {
+                best = node;
+                node = node->left;
+            }
+        }
+        return iterator(best);
+    }
+
+    // First element whose key is greater than key.
+    iterator upperBound(const Key& key) const {
+        Node* node = root;
+        Node* best = nullptr;
+        while (node) {
+            if (compare(key, node->entry.first)) {
+                best = node;
+                node = node->left;
+            } else {
+                node = node->right;
+            }
+        }
+        return iterator(best);
+    }
+
+    // Elements with low <= key < high, in order.
+    Range range(const Key& low, const Key& high) const {
+        if (!compare(low, high)) {
+            return {end(), end()};
+        }
+        return {lowerBound(low), lowerBound(high)};
+    }
+
+    bool erase(const Key& key) {
+        iterator found = find(key);
+        if (found == end()) {
+            return false;
+        }
+        Node* node = found.node;
+        Node* rebalanceStart;
+        if (!node->left || !node->right) {
+            rebalanceStart = node->parent;
+            transplant(node, node->left ? node->left : node->right);
+        } else {
+            // Two children: the in-order successor (which has no left child) takes the node's place.
+            Node* successor = leftmost(node->right);
+            if (successor->parent != node) {
+                rebalanceStart = successor->parent;
+                transplant(successor, successor->right);
+                successor->right = node->right;
+                successor->right->parent = successor;
+            } else {
+                rebalanceStart = successor;
+            }
+            transplant(node, successor);
+            successor->left = node->left;
+            successor->left->parent = successor;
+            successor->height = node->height;
+        }
+        pool.destroy(node);
+        --count;
+        rebalanceFrom(rebalanceStart);
+        return true;
+    }
+
+    void clear() {
+        // Post-order release with an explicit stack; the depth is bounded by the AVL height.
+        std::vector<Node*> pending;
+        if (root) {
+            pending.push_back(root);
+        }
+        while (!pending.empty()) {
+            Node* node = pending.back();
+            pending.pop_back();
+            if (node->left) {
+                pending.push_back(node->left);
+            }
+            if (node->right) {
+                pending.push_back(node->right);
+            }
+            pool.destroy(node);
+        }
+        root = nullptr;
+        count = 0;
+    }
+
+private:
+    struct Node {
+        value_type entry;
+        Node* left = nullptr;
+        Node* right = nullptr;
+        Node* parent;
+        int height = 1;
+
+        Node(const Key& key, Value value, Node* up) : entry(key, std::move(value)), parent(up) {}
+    };
+
+    Node* root = nullptr;
+    std::size_t count = 0;
+    Compare compare;
+    NodePool<Node> pool;
+
+    static int heightOf(const Node* node) {
+        return node ? node->height : 0;
+    }
+
+    static Node* leftmost(Node* node) {
+        while (node->left) {
+            node = node->left;
+        }
+        return node;
+    }
+
+    static void updateHeight(Node* node) {
+        node->height = 1 + std::max(heightOf(node->left), heightOf(node->right));
+    }
+
+    // Points whatever referred to from (its parent's child link, or root) at to instead.
+    void transplant(Node* from, Node* to) {
+        if (!from->parent) {
+            root = to;
+        } else if (from == from->parent->left) {
+            from->parent->left = to;
+        } else {
+            from->parent->right = to;
+        }
+        if (to) {
+            to->parent = from->parent;
+        }
+    }
+
+    // Lifts node's right child into node's place: node becomes the pivot's left child and adopts the
+    // pivot's old left subtree as its right one. The in-order sequence is unchanged.
+    Node* rotateLeft(Node* node) {
+        Node* pivot = node->right;
+        transplant(node, pivot);
+        node->right = pivot->left;
+        if (node->right) {
+            node->right->parent = node;
+        }
+        pivot->left = node;
+        node->parent = pivot;
+        updateHeight(node);
+        updateHeight(pivot);
+        return pivot;
+    }
+
+    // Mirror image of rotateLeft.
+    Node* rotateRight(Node* node) {
+        Node* pivot = node->left;
+        transplant(node, pivot);
+        node->left = pivot->right;
+        if (node->left) {
+            node->left->parent = node;
+        }
+        pivot->right = node;
+        node->parent = pivot;
+        updateHeight(node);
+        updateHeight(pivot);
+        return pivot;
+    }
+
+    // Walks from node to the root, fixing heights and rotating wherever the subtree heights differ by
+    // two. Once a subtree ends up with the height it had before the change, nothing above it can have
+    // changed either, so the walk stops early; an insert needs at most one (single or double) rotation.
+    void rebalanceFrom(Node* node) {
+        while (node) {
+            int before = node->height;
+            updateHeight(node);
+            int balance = heightOf(node->left) - heightOf(node->right);
+            if (balance > 1) {
+                if (heightOf(node->left->left) < heightOf(node->left->right)) {
+                    rotateLeft(node->left);
+                }
+                node = rotateRight(node);
+            } else if (balance < -1) {
+                if (heightOf(node->right->right) < heightOf(node->right->left)) {
+                    rotateRight(node->right);
+                }
+                node = rotateLeft(node);
+            }
+            if (node->height == before) {
+                return;
+            }
+            node = node->parent;
+        }
+    }
+};
+
+// Times inserts followed by a lookup of every key. The unbalanced tree gets a small sorted run because it
+// degrades to a list there (quadratic time, and recursion as deep as the key count); the balanced map and
+// std::map are also timed on a large sorted run and on random keys.
+void runTreeBenchmark() {
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::string workload;
+    auto time = [&](const char* name, const std::vector<int>& keys, auto&& tree) {
+        auto start = std::chrono::steady_clock::now();
+        for (int key : keys) {
+            tree.insert(key, key);
+        }
+        auto inserted = std::chrono::steady_clock::now();
+        std::size_t found = 0;
+        for (int key : keys) {
+            found += tree.contains(key) ? 1 : 0;
+        }
+        auto end = std::chrono::steady_clock::now();
+        std::cout << "  " << name << ": insert " << ms(start, inserted) << " ms, lookup " << ms(inserted, end)
+                  << " ms (found " << found << ")\n";
+        double perKey = 1e6 / static_cast<double>(keys.size());
+        bench::record(std::string(name) + " " + workload + " insert ns/op", ms(start, inserted) * perKey);
+        bench::record(std::string(name) + " " + workload + " lookup ns/op", ms(inserted, end) * perKey);
+    };
+    // Adapters give BinarySearchTree and std::map the same insert(key, value)/contains shape as AvlMap.
+    struct UnbalancedAdapter {
+        BinarySearchTree tree;
+        void insert(int key, int) {
+            tree.insert(key);
+        }
+        bool contains(int key) const {
+            return tree.contains(key);
+        }
+    };
+    struct StdMapAdapter {
+        std::map<int, int> map;
+        void insert(int key, int value) {
+            map.emplace(key, value);
+        }
+        bool contains(int key) const {
+            return map.count(key) != 0;
+        }
+    };
+
+    std::vector<int> smallSorted = bench::makeKeys(bench::Distribution::Sorted, 20000);
+    workload = "sorted 20000";
+    std::cout << "Tree benchmark: " << smallSorted.size() << " keys in sorted order\n";
+    time("BinarySearchTree", smallSorted, UnbalancedAdapter{});
+    time("AvlMap", smallSorted, AvlMap<int, int>{});
+    time("std::map", smallSorted, StdMapAdapter{});
+
+    std::vector<int> sorted = bench::makeKeys(bench::Distribution::Sorted, 1 << 21);
+    workload = "sorted " + std::to_string(sorted.size());
+    std::cout << "Tree benchmark: " << sorted.size() << " keys in sorted order\n";
+    time("AvlMap", sorted, AvlMap<int, int>{});
+    time("std::map", sorted, StdMapAdapter{});
+
+    std::vector<int> shuffled = sorted;
+    bench::Rng(29).shuffle(shuffled);
+    workload = "shuffled " + std::to_string(shuffled.size());
+    std::cout << "Tree benchmark: " << shuffled.size() << " keys in random order\n";
+    time("BinarySearchTree", shuffled, UnbalancedAdapter{});
+    time("AvlMap", shuffled, AvlMap<int, int>{});
+    time("std::map", shuffled, StdMapAdapter{});
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("bst_unique", argc, argv);
+        suite.run("tree", runTreeBenchmark);
+        return suite.finish();
+    }
+
     BinarySearchTree tree;
     // Insert a handful of keys; BST insert positions them so in-order traversal prints sorted order.
     tree.insert(50);
@@ -181,5 +641,24 @@ int main() {
     std::cout << "In-order after removing 50: ";
     tree.printInOrder();
 
+    // The balanced map stays shallow even when keys arrive in sorted order, and replaces printing with
+    // ordered iteration: the whole map, or any key range starting from lowerBound.
+    AvlMap<int, std::string> map;
+    for (int key = 10; key <= 100; key += 10) {
+        map.insert(key, "v" + std::to_string(key));
+    }
+    std::cout << "AvlMap with " << map.size() << " sorted inserts has height " << map.height() << "\n";
+    map.erase(50);
+    std::cout << "AvlMap in order after erasing 50:";
+    for (const auto& entry : map) {
+        std::cout << ' ' << entry.first << '=' << entry.second;
+    }
+    std::cout << "\nAvlMap keys in [25, 75):";
+    for (const auto& entry : map.range(25, 75)) {
+        std::cout << ' ' << entry.first;
+    }
+    auto bound = map.lowerBound(55);
+    std::cout << "\nAvlMap lowerBound(55): " << (bound != map.end() ? bound->first : -1) << "\n";
+
     return 0;
 }
@@ -1,5 +1,18 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <queue>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench_harness.h"
 
 // This program implements a Binary Search Tree variant that admits duplicate keys.
 // Rather than storing duplicates in separate nodes, each tree node tracks a frequency count.
@@ -169,7 +182,403 @@ private:
     }
 };
 
-int main() {
+// Balanced multiset with order statistics. Like MultisetBST each node holds one distinct key and its
+// multiplicity, but the tree is kept AVL-balanced (subtree heights differ by at most one) and every node
+// also caches `total`, the number of elements in its subtree counting duplicates. With those aggregates
+// rank, select, and range counts take one root-to-leaf walk each, O(log n), instead of an in-order
+// traversal: the walk adds up the totals of the left subtrees it skips over.
+class OrderStatisticMultiset {
+public:
+    OrderStatisticMultiset() = default;
+
+    // Builds the tree from sorted (possibly repeating) keys in O(n): runs of equal keys collapse into one
+    // node each, and the distinct keys are arranged into a perfectly balanced tree by repeatedly taking
+    // the middle one as subtree root, with no comparisons or rotations.
+    explicit OrderStatisticMultiset(const std::vector<int>& sorted) {
+        if (!std::is_sorted(sorted.begin(), sorted.end())) {
+            throw std::invalid_argument("OrderStatisticMultiset requires sorted input");
+        }
+        std::vector<std::pair<int, std::size_t>> runs;
+        for (int key : sorted) {
+            if (!runs.empty() && runs.back().first == key) {
+                ++runs.back().second;
+            } else {
+                runs.emplace_back(key, 1);
+            }
+        }
+        root = buildBalanced(runs, 0, runs.size());
+    }
+
+    ~OrderStatisticMultiset() {
+        destroy(root);
+    }
+
+    OrderStatisticMultiset(const OrderStatisticMultiset&) = delete;
+    OrderStatisticMultiset& operator=(const OrderStatisticMultiset&) = delete;
+
+    // Number of elements, counting duplicates.
+    std::size_t size() const {
+        return totalOf(root);
+    }
+
+    int height() const {
+        return heightOf(root);
+    }
+
+    void insert(int key, std::size_t copies = 1) {
+        if (copies > 0) {
+            root = insertRecursive(root, key, copies);
+        }
+    }
+
+    // Removes one occurrence; returns false when the key is absent.
+    bool eraseOne(int key) {
+        std::size_t removed = 0;
+        root = eraseRecursive(root, key, false, removed);
+        return removed != 0;
+    }
+
+    // Removes every occurrence and returns how many there were.
+    std::size_t eraseAll(int key) {
+        std::size_t removed = 0;
+        root = eraseRecursive(root, key, true, removed);
+        return removed;
+    }
+
+    std::size_t count(int key) const {
+        const OsNode* node = root;
+        while (node) {
+            if (key < node->key) {
+                node = node->left;
+            } else if (key > node->key) {
+                node = node->right;
+            } else {
+                return node->count;
+            }
+        }
+        return 0;
+    }
+
+    bool contains(int key) const {
+        return count(key) != 0;
+    }
+
+    // Number of elements strictly less than key.
+    std::size_t rank(int key) const {
+        std::size_t below = 0;
+        const OsNode* node = root;
+        while (node) {
+            if (key <= node->key) {
+                node = node->left;
+            } else {
+                // Everything in the left subtree and every copy of this node precede key.
+                below += totalOf(node->left) + node->count;
+                node = node->right;
+            }
+        }
+        return below;
+    }
+
+    // Number of elements less than or equal to key.
+    std::size_t rankUpper(int key) const {
+        std::size_t atOrBelow = 0;
+        const OsNode* node = root;
+        while (node) {
+            if (key < node->key) {
+                node = node->left;
+            } else {
+                atOrBelow += totalOf(node->left) + node->count;
+                node = node->right;
+            }
+        }
+        return atOrBelow;
+    }
+
+    // Number of elements with low <= key <= high.
+    std::size_t countInRange(int low, int high) const {
+        return low > high ? 0 : rankUpper(high) - rank(low);
+    }
+
+    // The element at zero-based position k of the sorted order, duplicates included.
+    int select(std::size_t k) const {
+        if (k >= size()) {
+            throw std::out_of_range("select index past the end of the multiset");
+        }
+        const OsNode* node = root;
+        for (;;) {
+            std::size_t leftTotal = totalOf(node->left);
+            if (k < leftTotal) {
+                node = node->left;
+            } else if (k < leftTotal + node->count) {
+                return node->key;
+            } else {
+                k -= leftTotal + node->count;
+                node = node->right;
+            }
+        }
+    }
+
+    // Zero-based index of the nearest-rank quantile among count >= 1 sorted values: the smallest
+    // value with at least fraction * count values at or below it, i.e. ceil(fraction * count) - 1.
+    // Fractions such as 0.07 have no exact binary form, so the product can land an ulp above an exact
+    // rank (0.07 * 100 == 7.000000000000001) and ceil would step one value too far. Shaving a few ulps
+    // off first absorbs that rounding while moving a genuinely fractional product by far less than a rank.
+    static std::size_t nearestRank(double fraction, std::size_t count) {
+        fraction = std::min(std::max(fraction, 0.0), 1.0);
+        double product = fraction * static_cast<double>(count);
+        product -= product * 4 * std::numeric_limits<double>::epsilon();
+        auto rank = static_cast<std::size_t>(std::ceil(product));
+        return rank == 0 ? 0 : std::min(rank, count) - 1;
+    }
+
+    // Nearest-rank quantile for fraction in [0, 1], e.g. 0.99 for the 99th percentile.
+    int quantile(double fraction) const {
+        if (size() == 0) {
+            throw std::out_of_range("quantile of an empty multiset");
+        }
+        return select(nearestRank(fraction, size()));
+    }
+
+    void printInOrder() const {
+        printInOrderRecursive(root);
+        std::cout << "\n";
+    }
+
+private:
+    struct OsNode {
+        int key;
+        std::size_t count;
+        std::size_t total;
+        int height = 1;
+        OsNode* left = nullptr;
+        OsNode* right = nullptr;
+
+        OsNode(int k, std::size_t copies) : key(k), count(copies), total(copies) {}
+    };
+
+    OsNode* root = nullptr;
+
+    static std::size_t totalOf(const OsNode* node) {
+        return node ? node->total : 0;
+    }
+
+    static int heightOf(const OsNode* node) {
+        return node ? node->height : 0;
+    }
+
+    // Recomputes a node's cached aggregates from its children; called bottom-up after every change.
+    static void update(OsNode* node) {
+        node->height = 1 + std::max(heightOf(node->left), heightOf(node->right));
+        node->total = node->count + totalOf(node->left) + totalOf(node->right);
+    }
+
+    static OsNode* rotateLeft(OsNode* node) {
+        OsNode* pivot = node->right;
+        node->right = pivot->left;
+        pivot->left = node;
+        update(node);
+        update(pivot);
+        return pivot;
+    }
+
+    static OsNode* rotateRight(OsNode* node) {
+        OsNode* pivot = node->left;
+        node->left = pivot->right;
+        pivot->right = node;
+        update(node);
+        update(pivot);
+        return pivot;
+    }
+
+    // Restores the AVL invariant at node (its children already satisfy it) and returns the subtree root.
+    static OsNode* rebalance(OsNode* node) {
+        update(node);
+        int balance = heightOf(node->left) - heightOf(node->right);
+        if (balance > 1) {
+            if (heightOf(node->left->left) < heightOf(node->left->right)) {
+                node->left = rotateLeft(node->left);
+            }
+            return rotateRight(node);
+        }
+        if (balance < -1) {
+            if (heightOf(node->right->right) < heightOf(node->right->left)) {
+                node->right = rotateRight(node->right);
+            }
+            return rotateLeft(node);
+        }
+        return node;
+    }
+
+    static OsNode* buildBalanced(const std::vector<std::pair<int, std::size_t>>& runs, std::size_t first,
+                                 std::size_t last) {
+        if (first == last) {
+            return nullptr;
+        }
+        std::size_t middle = first + (last - first) / 2;
+        OsNode* node = new OsNode(runs[middle].first, runs[middle].second);
+        node->left = buildBalanced(runs, first, middle);
+        node->right = buildBalanced(runs, middle + 1, last);
+        update(node);
+        return node;
+    }
+
+    static OsNode* insertRecursive(OsNode* node, int key, std::size_t copies) {
+        if (!node) {
+            return new OsNode(key, copies);
+        }
+        if (key < node->key) {
+            node->left = insertRecursive(node->left, key, copies);
+        } else if (key > node->key) {
+            node->right = insertRecursive(node->right, key, copies);
+        } else {
+            // The shape is unchanged, but every total on the path back up grows.
+            node->count += copies;
+            node->total += copies;
+            return node;
+        }
+        return rebalance(node);
+    }
+
+    // Unlinks the minimum node of a subtree into detached and returns the rebalanced remainder.
+    static OsNode* detachMin(OsNode* node, OsNode*& detached) {
+        if (!node->left) {
+            detached = node;
+            return node->right;
+        }
+        node->left = detachMin(node->left, detached);
+        return rebalance(node);
+    }
+
+    static OsNode* eraseRecursive(OsNode* node, int key, bool removeAll, std::size_t& removed) {
+        if (!node) {
+            return nullptr;
+        }
+        if (key < node->key) {
+            node->left = eraseRecursive(node->left, key, removeAll, removed);
+        } else if (key > node->key) {
+            node->right = eraseRecursive(node->right, key, removeAll, removed);
+        } else if (!removeAll && node->count > 1) {
+            --node->count;
+            --node->total;
+            removed = 1;
+            return node;
+        } else {
+            removed = node->count;
+            OsNode* left = node->left;
+            OsNode* right = node->right;
+            delete node;
+            if (!left || !right) {
+                return left ? left : right;
+            }
+            // The in-order successor is unlinked from the right subtree and takes the node's place.
+            OsNode* successor = nullptr;
+            right = detachMin(right, successor);
+            successor->left = left;
+            successor->right = right;
+            return rebalance(successor);
+        }
+        return removed != 0 ? rebalance(node) : node;
+    }
+
+    static void printInOrderRecursive(const OsNode* node) {
+        if (!node) {
+            return;
+        }
+        printInOrderRecursive(node->left);
+        for (std::size_t i = 0; i < node->count; ++i) {
+            std::cout << node->key << ' ';
+        }
+        printInOrderRecursive(node->right);
+    }
+
+    static void destroy(OsNode* node) {
+        if (!node) {
+            return;
+        }
+        destroy(node->left);
+        destroy(node->right);
+        delete node;
+    }
+};
+
+// Streams synthetic latency samples (log-normal, in microseconds) and asks for p50/p99/p99.9 after every
+// block, comparing select on the aggregated tree with walking a std::multiset to the wanted position,
+// which is what an in-order traversal amounts to. Then compares the O(n) bulk build with n inserts.
+void runOrderStatisticBenchmark() {
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    const std::size_t sampleCount = 1 << 20;
+    const std::size_t queryEvery = 1 << 16;
+    bench::Rng rng(83);
+    std::vector<int> samples(sampleCount);
+    for (int& sample : samples) {
+        // Log-normal with mu 5 and sigma 0.8: a median near 150 us and a long right tail.
+        sample = static_cast<int>(std::exp(5.0 + 0.8 * rng.normal()));
+    }
+    auto perOp = [&ms](auto from, auto to, std::size_t ops) { return ms(from, to) * 1e6 / static_cast<double>(ops); };
+    const double fractions[] = {0.5, 0.99, 0.999};
+
+    std::cout << "Order statistic benchmark: " << sampleCount << " samples, 3 percentiles every " << queryEvery
+              << "\n";
+    auto start = std::chrono::steady_clock::now();
+    OrderStatisticMultiset tree;
+    long long treeChecksum = 0;
+    for (std::size_t i = 0; i < sampleCount; ++i) {
+        tree.insert(samples[i]);
+        if ((i + 1) % queryEvery == 0) {
+            for (double fraction : fractions) {
+                treeChecksum += tree.quantile(fraction);
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "  OrderStatisticMultiset " << ms(start, end) << " ms (checksum " << treeChecksum << ", height "
+              << tree.height() << ")\n";
+    bench::record("OrderStatisticMultiset ns/sample", perOp(start, end, sampleCount));
+
+    start = std::chrono::steady_clock::now();
+    std::multiset<int> walked;
+    long long walkChecksum = 0;
+    for (std::size_t i = 0; i < sampleCount; ++i) {
+        walked.insert(samples[i]);
+        if ((i + 1) % queryEvery == 0) {
+            for (double fraction : fractions) {
+                auto position = OrderStatisticMultiset::nearestRank(fraction, walked.size());
+                walkChecksum += *std::next(walked.begin(), static_cast<std::ptrdiff_t>(position));
+            }
+        }
+    }
+    end = std::chrono::steady_clock::now();
+    std::cout << "  std::multiset walk " << ms(start, end) << " ms (checksum " << walkChecksum << ")\n";
+    bench::record("std::multiset walk ns/sample", perOp(start, end, sampleCount));
+
+    std::vector<int> sorted(1 << 22);
+    for (int& value : sorted) {
+        value = static_cast<int>(rng.below(1 << 24));
+    }
+    std::sort(sorted.begin(), sorted.end());
+    std::cout << "Bulk build benchmark: " << sorted.size() << " sorted keys\n";
+    start = std::chrono::steady_clock::now();
+    OrderStatisticMultiset built(sorted);
+    end = std::chrono::steady_clock::now();
+    std::cout << "  sorted constructor " << ms(start, end) << " ms (height " << built.height() << ")\n";
+    bench::record("sorted constructor ns/key", perOp(start, end, sorted.size()));
+    start = std::chrono::steady_clock::now();
+    OrderStatisticMultiset inserted;
+    for (int value : sorted) {
+        inserted.insert(value);
+    }
+    end = std::chrono::steady_clock::now();
+    std::cout << "  one insert per key " << ms(start, end) << " ms (height " << inserted.height() << ")\n";
+    bench::record("one insert per key ns/key", perOp(start, end, sorted.size()));
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("bst_with_duplicates", argc, argv);
+        suite.run("order_statistic", runOrderStatisticBenchmark);
+        return suite.finish();
+    }
+
     MultisetBST multisetTree;
     // Insert values intentionally repeating 5 and 10 to exercise the per-node frequency counter.
     multisetTree.insert(10);
@@ -196,5 +605,28 @@ int main() {
     std::cout << "After erasing all 5s: ";
     multisetTree.printInOrder();
 
+    // The balanced variant answers order-statistic questions without a traversal.
+    OrderStatisticMultiset samples({3, 5, 5, 8, 8, 8, 13, 21});
+    samples.insert(8);
+    samples.eraseOne(21);
+    std::cout << "Order-statistic multiset: ";
+    samples.printInOrder();
+    std::cout << "rank(8) = " << samples.rank(8) << ", count(8) = " << samples.count(8) << ", select(2) = "
+              << samples.select(2) << ", values in [4, 10]: " << samples.countInRange(4, 10)
+              << ", median = " << samples.quantile(0.5) << "\n";
+
+    // Exact products must hit their rank even when the double product does not: 0.07 * 100 rounds to
+    // 7.000000000000001, yet p7 of 100 values is still the 7th. Integer arithmetic gives the reference.
+    bool exactRanks = true;
+    for (std::size_t n = 1; n <= 200; ++n) {
+        for (std::size_t percent = 0; percent <= 100; ++percent) {
+            std::size_t rank = (percent * n + 99) / 100;
+            std::size_t expected = rank == 0 ? 0 : rank - 1;
+            double fraction = static_cast<double>(percent) / 100.0;
+            exactRanks = exactRanks && OrderStatisticMultiset::nearestRank(fraction, n) == expected;
+        }
+    }
+    std::cout << "Nearest rank exact for every whole percent of n <= 200? " << (exactRanks ? "yes" : "no") << "\n";
+
     return 0;
 }
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+// Allocates storage on 64-byte boundaries, so containers whose layout is planned around cache lines
+// (min_max_heap.cpp's blocked sibling groups, binary_search.cpp's Eytzinger and B+-tree node blocks)
+// get lines that actually start where the layout expects. Copies of such a container stay aligned too:
+// a copied std::vector takes fresh storage from the same allocator rather than whatever alignment
+// plain operator new happens to return.
+template <typename T>
+struct CacheAlignedAllocator {
+    using value_type = T;
+    static constexpr std::size_t kAlignment = 64;
+
+    CacheAlignedAllocator() = default;
+
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(kAlignment)));
+    }
+
+    void deallocate(T* pointer, std::size_t) {
+        ::operator delete(pointer, std::align_val_t(kAlignment));
+    }
+
+    template <typename U>
+    bool operator==(const CacheAlignedAllocator<U>&) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const CacheAlignedAllocator<U>&) const {
+        return false;
+    }
+};
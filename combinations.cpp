@@ -1,6 +1,19 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "bench_harness.h"
+#include "thread_slices.h"
+
 // This program prints all k-combinations of a given set using recursive backtracking.
 // At each recursion level we decide whether to include the current element, advancing
 // through the array while tracking how many elements are left to pick. The active selection
@@ -31,7 +44,194 @@ void generateCombinations(const std::vector<int>& items, size_t index, int k,
     generateCombinations(items, index + 1, k, current);
 }
 
-int main() {
+// C(n, k) in 64 bits, throwing std::overflow_error when it does not fit. Each step multiplies by
+// (n - k + i) and divides by i; dividing out their common factor first keeps the intermediate product
+// no larger than the result except when the result itself overflows.
+inline std::uint64_t binomial(std::uint64_t n, std::uint64_t k) {
+    if (k > n) {
+        return 0;
+    }
+    k = std::min(k, n - k);
+    std::uint64_t result = 1;
+    for (std::uint64_t i = 1; i <= k; ++i) {
+        std::uint64_t factor = n - k + i;
+        std::uint64_t common = std::gcd(result, i);
+        result /= common;
+        // result * factor is divisible by i, and result no longer shares a factor with i / common.
+        factor /= i / common;
+        if (result > std::numeric_limits<std::uint64_t>::max() / factor) {
+            throw std::overflow_error("binomial coefficient does not fit in 64 bits");
+        }
+        result *= factor;
+    }
+    return result;
+}
+
+// Lazily enumerates a slice of the k-combinations of items[0..n) in lexicographic order of positions,
+// writing each one into the caller's out[0..k) buffer. The generator keeps the chosen positions in a
+// fixed inline array, so it never allocates. Construction unranks straight to combination number
+// `first`: for each output slot it skips whole blocks of C(n - c - 1, k - slot - 1) combinations
+// that start with a smaller position c. After that, next() steps like an odometer. It bumps the
+// rightmost position that can still move, resets the ones after it, and rewrites only the output slots
+// that changed, which is amortized O(1) per combination.
+class CombinationGenerator {
+public:
+    static constexpr std::size_t kMaxK = 64;
+
+    CombinationGenerator(const int* items, std::size_t n, std::size_t k, int* out, std::uint64_t first = 0,
+                         std::uint64_t count = std::numeric_limits<std::uint64_t>::max())
+        : items(items), n(n), k(k), out(out) {
+        if (k > kMaxK) {
+            throw std::invalid_argument("CombinationGenerator supports k up to 64");
+        }
+        std::uint64_t total = binomial(n, k);
+        remaining = first < total ? std::min(count, total - first) : 0;
+        if (remaining == 0) {
+            return;
+        }
+        std::size_t candidate = 0;
+        for (std::size_t slot = 0; slot < k; ++slot, ++candidate) {
+            for (;;) {
+                std::uint64_t block = binomial(n - candidate - 1, k - slot - 1);
+                if (first < block) {
+                    break;
+                }
+                first -= block;
+                ++candidate;
+            }
+            positions[slot] = candidate;
+            out[slot] = items[candidate];
+        }
+    }
+
+    // Advances to the next combination of the slice; returns false once the slice is exhausted.
+    bool next() {
+        if (remaining == 0) {
+            return false;
+        }
+        --remaining;
+        if (!started) {
+            started = true;
+            return true;
+        }
+        // Slot i can still move while positions[i] < n - k + i; the caller's count keeps us in range.
+        std::size_t slot = k;
+        while (positions[slot - 1] == n - k + slot - 1) {
+            --slot;
+        }
+        --slot;
+        ++positions[slot];
+        out[slot] = items[positions[slot]];
+        for (std::size_t after = slot + 1; after < k; ++after) {
+            positions[after] = positions[after - 1] + 1;
+            out[after] = items[positions[after]];
+        }
+        return true;
+    }
+
+    const int* current() const {
+        return out;
+    }
+
+private:
+    const int* items;
+    std::size_t n;
+    std::size_t k;
+    int* out;
+    std::uint64_t remaining;
+    bool started = false;
+    std::array<std::size_t, kMaxK> positions{};
+};
+
+// Visits all k-combinations of items across threads, each thread unranking to the start of its own
+// slice. visit(const int* combination, unsigned thread) must be safe to call concurrently. k is checked
+// before any thread starts, so an oversized k throws to the caller instead of from every worker.
+template <typename Visitor>
+void forEachCombinationParallel(const std::vector<int>& items, std::size_t k, unsigned threads, Visitor visit) {
+    if (k > CombinationGenerator::kMaxK) {
+        throw std::invalid_argument("forEachCombinationParallel supports k up to 64");
+    }
+    forEachSlice(binomial(items.size(), k), threads, [&](std::uint64_t first, std::uint64_t count, unsigned t) {
+        std::array<int, CombinationGenerator::kMaxK> buffer;
+        for (CombinationGenerator generator(items.data(), items.size(), k, buffer.data(), first, count);
+             generator.next();) {
+            visit(generator.current(), t);
+        }
+    });
+}
+
+// Sums every 6-of-40 combination (3.8M) three ways: the lazy generator, the same work sliced across
+// threads by unranking, and the recursive include/exclude enumeration turned into a visitor.
+void runCombinationBenchmark() {
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::vector<int> items(40);
+    std::iota(items.begin(), items.end(), 1);
+    const std::size_t k = 6;
+    auto score = [k](const int* combination) {
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < k; ++i) {
+            sum += static_cast<std::uint64_t>(combination[i]) * combination[i];
+        }
+        return sum;
+    };
+    std::cout << "Combination benchmark: " << binomial(items.size(), k) << " combinations of " << k << " from "
+              << items.size() << "\n";
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t checksum = 0;
+    int buffer[k];
+    for (CombinationGenerator generator(items.data(), items.size(), k, buffer); generator.next();) {
+        checksum += score(generator.current());
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "  CombinationGenerator " << ms(start, end) << " ms (checksum " << checksum << ")\n";
+    bench::record("generator ms", ms(start, end));
+
+    for (unsigned threads : {2u, 4u}) {
+        std::vector<PaddedCounter> partial(threads);
+        start = std::chrono::steady_clock::now();
+        forEachCombinationParallel(items, k, threads, [&](const int* combination, unsigned t) {
+            partial[t].value += score(combination);
+        });
+        end = std::chrono::steady_clock::now();
+        checksum = 0;
+        for (const PaddedCounter& sum : partial) {
+            checksum += sum.value;
+        }
+        std::cout << "  forEachCombinationParallel, " << threads << " threads " << ms(start, end)
+                  << " ms (checksum " << checksum << ")\n";
+        bench::record("parallel " + std::to_string(threads) + " threads ms", ms(start, end));
+    }
+
+    start = std::chrono::steady_clock::now();
+    checksum = 0;
+    std::vector<int> current;
+    std::function<void(std::size_t)> recurse = [&](std::size_t index) {
+        if (current.size() == k) {
+            checksum += score(current.data());
+            return;
+        }
+        if (index == items.size()) {
+            return;
+        }
+        current.push_back(items[index]);
+        recurse(index + 1);
+        current.pop_back();
+        recurse(index + 1);
+    };
+    recurse(0);
+    end = std::chrono::steady_clock::now();
+    std::cout << "  recursive backtracking " << ms(start, end) << " ms (checksum " << checksum << ")\n";
+    bench::record("recursive ms", ms(start, end));
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("combinations", argc, argv);
+        suite.run("combinations", runCombinationBenchmark);
+        return suite.finish();
+    }
+
     std::vector<int> values = {1, 2, 3, 4};
     int k = 2;
 
@@ -39,5 +239,13 @@ int main() {
     // Start the recursion with an empty slate, trusting the helper to expand the search tree.
     generateCombinations(values, 0, k, current);
 
+    // The lazy generator fills a caller buffer and can start at any rank, e.g. combinations 2..4.
+    int buffer[2];
+    std::cout << "Combinations ranked 2..4:";
+    for (CombinationGenerator generator(values.data(), values.size(), 2, buffer, 2, 3); generator.next();) {
+        std::cout << " {" << buffer[0] << ',' << buffer[1] << '}';
+    }
+    std::cout << "\n";
+
     return 0;
 }
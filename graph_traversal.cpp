@@ -1,14 +1,64 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <queue>
 #include <stack>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
+#include "bench_harness.h"
+#include "mapped_file.h"
+
 // This program demonstrates Depth-First Search (DFS) and Breadth-First Search (BFS) on an
 // unweighted graph. The graph is stored as an adjacency list using an unordered_map where each
 // vertex maps to its neighbors. This structure keeps lookups near O(1) average time and is
 // space-efficient for sparse graphs. DFS uses an explicit stack to dive deep, while BFS uses a
 // queue to explore level by level.
+//
+// Hash-based adjacency is convenient while a graph is being assembled but makes every neighbor check a
+// hash lookup. CsrGraph freezes a Graph into compressed sparse row form for fast repeated traversals,
+// including multi-threaded BFS and connected components (build with -pthread). Large graphs can be
+// loaded in bulk with Graph::addEdges or straight from a memory-mapped binary edge list.
+
+// What a traversal reports for each vertex it reaches: the vertex, the vertex it was reached from
+// (-1 for the start), and its depth in the traversal tree.
+struct TraversalStep {
+    int vertex;
+    int parent;
+    int depth;
+};
+
+// Visitors may return void to see every vertex, or bool where false stops the traversal early.
+template <typename Visitor>
+bool continueAfter(Visitor& visit, const TraversalStep& step) {
+    if constexpr (std::is_void<decltype(visit(step))>::value) {
+        visit(step);
+        return true;
+    } else {
+        return static_cast<bool>(visit(step));
+    }
+}
+
+// One edge of a binary edge-list file: two native-endian 32-bit vertex labels. The member names match
+// std::pair so bulk loaders accept either type.
+struct EdgeRecord {
+    std::int32_t first;
+    std::int32_t second;
+};
+static_assert(sizeof(EdgeRecord) == 8, "Edge-list files store tightly packed 8-byte records");
 
 class Graph {
 public:
@@ -16,28 +66,148 @@ public:
         // Each adjacency entry stores neighbors in a vector so we can iterate quickly.
         adjacency[from].push_back(to);
         adjacency[to].push_back(from); // Undirected graph for illustration.
+        if (weighted) {
+            weights[from].push_back(1.0);
+            weights[to].push_back(1.0);
+        }
+    }
+
+    // Adds a batch of undirected edges given as std::pair<int, int> or EdgeRecord. Each distinct vertex
+    // in the batch is looked up in the table once: a first pass gives every label a batch-local index
+    // and counts its new edges, each touched neighbor list is then resized exactly, and the fill pass
+    // appends through the resolved lists without hashing or reallocating. When the labels span a range
+    // no wider than a few times the edge count (dumps with dense IDs), the local index is the label's
+    // offset in that range and the batch does no per-edge hashing at all.
+    template <typename EdgeIt>
+    void addEdges(EdgeIt first, EdgeIt last) {
+        std::size_t endpoints = 0;
+        long long low = std::numeric_limits<int>::max();
+        long long high = std::numeric_limits<int>::min();
+        for (EdgeIt it = first; it != last; ++it) {
+            low = std::min<long long>(low, std::min<long long>(it->first, it->second));
+            high = std::max<long long>(high, std::max<long long>(it->first, it->second));
+            endpoints += 2;
+        }
+        if (endpoints == 0) {
+            return;
+        }
+        bool flat = static_cast<unsigned long long>(high - low) < 4 * endpoints + 1024;
+
+        // Batch-local index of every endpoint, in edge order; only needed when labels are sparse.
+        std::vector<std::uint32_t> localIds;
+        std::unordered_map<int, std::uint32_t> localOf;
+        std::vector<int> labels;
+        std::vector<std::size_t> counts;
+        if (flat) {
+            counts.assign(static_cast<std::size_t>(high - low + 1), 0);
+            for (EdgeIt it = first; it != last; ++it) {
+                ++counts[static_cast<std::size_t>(it->first - low)];
+                ++counts[static_cast<std::size_t>(it->second - low)];
+            }
+        } else {
+            localIds.reserve(endpoints);
+            for (EdgeIt it = first; it != last; ++it) {
+                for (int label : {static_cast<int>(it->first), static_cast<int>(it->second)}) {
+                    auto inserted = localOf.emplace(label, static_cast<std::uint32_t>(labels.size()));
+                    if (inserted.second) {
+                        labels.push_back(label);
+                        counts.push_back(0);
+                    }
+                    ++counts[inserted.first->second];
+                    localIds.push_back(inserted.first->second);
+                }
+            }
+        }
+
+        std::vector<std::vector<int>*> lists(counts.size(), nullptr);
+        std::vector<std::vector<double>*> weightLists(weighted ? counts.size() : 0, nullptr);
+        adjacency.reserve(adjacency.size() + counts.size());
+        for (std::size_t local = 0; local < counts.size(); ++local) {
+            if (counts[local] == 0) {
+                continue;
+            }
+            int label = flat ? static_cast<int>(low + static_cast<long long>(local)) : labels[local];
+            lists[local] = &adjacency[label];
+            lists[local]->reserve(lists[local]->size() + counts[local]);
+            if (weighted) {
+                weightLists[local] = &weights[label];
+                weightLists[local]->reserve(weightLists[local]->size() + counts[local]);
+            }
+        }
+
+        std::size_t endpoint = 0;
+        for (EdgeIt it = first; it != last; ++it, endpoint += 2) {
+            std::size_t from = flat ? static_cast<std::size_t>(it->first - low) : localIds[endpoint];
+            std::size_t to = flat ? static_cast<std::size_t>(it->second - low) : localIds[endpoint + 1];
+            lists[from]->push_back(it->second);
+            lists[to]->push_back(it->first);
+            if (weighted) {
+                weightLists[from]->push_back(1.0);
+                weightLists[to]->push_back(1.0);
+            }
+        }
+    }
+
+    void addEdges(const std::vector<std::pair<int, int>>& edges) {
+        addEdges(edges.begin(), edges.end());
+    }
+
+    // Weighted edge for shortest-path queries. Weights live in lists parallel to the adjacency lists,
+    // created only once the first weighted edge arrives so that unweighted graphs pay nothing for them;
+    // at that point every existing edge gets weight 1. Dijkstra and delta-stepping need weights >= 0.
+    void addEdge(int from, int to, double weight) {
+        if (!(weight >= 0)) {
+            throw std::invalid_argument("Edge weights must be non-negative");
+        }
+        if (!weighted) {
+            for (const auto& entry : adjacency) {
+                weights[entry.first].assign(entry.second.size(), 1.0);
+            }
+            weighted = true;
+        }
+        adjacency[from].push_back(to);
+        adjacency[to].push_back(from);
+        weights[from].push_back(weight);
+        weights[to].push_back(weight);
     }
 
     void depthFirstSearch(int start) const {
+        std::cout << "DFS order: ";
+        visitDepthFirst(start, [](const TraversalStep& step) { std::cout << step.vertex << ' '; });
+        std::cout << "\n";
+    }
+
+    void breadthFirstSearch(int start) const {
+        std::cout << "BFS order: ";
+        visitBreadthFirst(start, [](const TraversalStep& step) { std::cout << step.vertex << ' '; });
+        std::cout << "\n";
+    }
+
+    // Calls visit(step) for each vertex in depth-first preorder. A visitor that returns false stops the
+    // traversal on the spot, for example once a target vertex has been found.
+    template <typename Visitor>
+    void visitDepthFirst(int start, Visitor visit) const {
         // The visited map tracks which vertices have already been processed to avoid cycles.
         std::unordered_map<int, bool> visited;
+        visited.reserve(adjacency.size());
         // Using an explicit stack replicates the call stack of a recursive DFS but keeps control iterative.
-        std::stack<int> stack;
-        stack.push(start);
-
-        std::cout << "DFS order: ";
+        // Each entry remembers who pushed it, which is the vertex's DFS-tree parent if it is visited from there.
+        std::stack<TraversalStep> stack;
+        stack.push({start, -1, 0});
 
         while (!stack.empty()) {
-            int vertex = stack.top();
+            TraversalStep step = stack.top();
             stack.pop();
 
-            if (visited[vertex]) {
+            if (visited[step.vertex]) {
                 continue;
             }
-            visited[vertex] = true;
-            std::cout << vertex << ' ';
+            visited[step.vertex] = true;
+            if (!continueAfter(visit, step)) {
+                return;
+            }
 
-            auto it = adjacency.find(vertex);
+            auto it = adjacency.find(step.vertex);
             if (it == adjacency.end()) {
                 continue;
             }
@@ -45,28 +215,31 @@ public:
             // Push neighbors in reverse to preserve intuitive left-to-right visiting order.
             for (auto rit = neighbors.rbegin(); rit != neighbors.rend(); ++rit) {
                 if (!visited[*rit]) {
-                    stack.push(*rit);
+                    stack.push({*rit, step.vertex, step.depth + 1});
                 }
             }
         }
-        std::cout << "\n";
     }
 
-    void breadthFirstSearch(int start) const {
+    // Calls visit(step) for each vertex in breadth-first order, where step.depth is the vertex's
+    // distance from start. Returning false from the visitor stops the traversal.
+    template <typename Visitor>
+    void visitBreadthFirst(int start, Visitor visit) const {
         // BFS leverages a queue so vertices are processed in the order they are discovered.
         std::unordered_map<int, bool> visited;
-        std::queue<int> queue;
-        queue.push(start);
+        visited.reserve(adjacency.size());
+        std::queue<TraversalStep> queue;
+        queue.push({start, -1, 0});
         visited[start] = true;
 
-        std::cout << "BFS order: ";
-
         while (!queue.empty()) {
-            int vertex = queue.front();
+            TraversalStep step = queue.front();
             queue.pop();
-            std::cout << vertex << ' ';
+            if (!continueAfter(visit, step)) {
+                return;
+            }
 
-            auto it = adjacency.find(vertex);
+            auto it = adjacency.find(step.vertex);
             if (it == adjacency.end()) {
                 continue;
             }
@@ -75,19 +248,1057 @@ public:
             for (int neighbor : neighbors) {
                 if (!visited[neighbor]) {
                     visited[neighbor] = true;
-                    queue.push(neighbor);
+                    queue.push({neighbor, step.vertex, step.depth + 1});
                 }
             }
         }
-        std::cout << "\n";
     }
 
 private:
+    friend class CsrGraph;
+
     // The adjacency list maps each vertex to a collection of immediate neighbors.
     std::unordered_map<int, std::vector<int>> adjacency;
+    // weights[v][k] is the weight of the edge to adjacency[v][k]; empty until the graph is weighted.
+    std::unordered_map<int, std::vector<double>> weights;
+    bool weighted = false;
+};
+
+// Index of the lowest set bit of a nonzero word, used to walk a Bitset one set bit at a time.
+inline unsigned lowestBit(std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+    unsigned bit = 0;
+    while ((word & 1) == 0) {
+        word >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+// Fixed-size bit array addressed by dense vertex ID: one bit per vertex keeps the visited set for
+// millions of vertices inside the cache, where a hash map or a vector<bool> of pointers would not fit.
+class Bitset {
+public:
+    explicit Bitset(std::size_t bits) : words((bits + 63) / 64, 0) {}
+
+    bool test(std::size_t index) const {
+        return (words[index >> 6] >> (index & 63)) & 1;
+    }
+
+    void set(std::size_t index) {
+        words[index >> 6] |= std::uint64_t(1) << (index & 63);
+    }
+
+    void clear() {
+        std::fill(words.begin(), words.end(), 0);
+    }
+
+    std::size_t wordCount() const {
+        return words.size();
+    }
+
+    std::uint64_t word(std::size_t index) const {
+        return words[index];
+    }
+
+private:
+    std::vector<std::uint64_t> words;
+};
+
+// Reusable rendezvous for a fixed group of threads. The last thread to arrive runs the completion step
+// alone, while the others are still parked, and then releases everyone; this is where parallel loops
+// do their serial bookkeeping between phases.
+class Barrier {
+public:
+    explicit Barrier(unsigned count) : threshold(count) {}
+
+    template <typename Completion>
+    void arriveAndWait(Completion completion) {
+        std::unique_lock<std::mutex> guard(lock);
+        std::size_t arrivalGeneration = generation;
+        if (++arrived == threshold) {
+            completion();
+            arrived = 0;
+            ++generation;
+            released.notify_all();
+        } else {
+            released.wait(guard, [&] { return generation != arrivalGeneration; });
+        }
+    }
+
+private:
+    std::mutex lock;
+    std::condition_variable released;
+    unsigned threshold;
+    unsigned arrived = 0;
+    std::size_t generation = 0;
+};
+
+// Starts threadCount threads running work(threadIndex) and waits for all of them.
+template <typename Work>
+void runOnThreads(unsigned threadCount, Work work) {
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threadCount; ++t) {
+        workers.emplace_back(work, t);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// Writes edges as a binary edge list that MappedEdgeList can load: tightly packed EdgeRecords, no header.
+template <typename EdgeIt>
+void writeEdgeList(EdgeIt first, EdgeIt last, const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot open edge list for writing: " + path);
+    }
+    std::vector<EdgeRecord> buffer;
+    buffer.reserve(1 << 16);
+    auto flush = [&]() {
+        out.write(reinterpret_cast<const char*>(buffer.data()),
+                  static_cast<std::streamsize>(buffer.size() * sizeof(EdgeRecord)));
+        buffer.clear();
+    };
+    for (EdgeIt it = first; it != last; ++it) {
+        buffer.push_back(EdgeRecord{it->first, it->second});
+        if (buffer.size() == buffer.capacity()) {
+            flush();
+        }
+    }
+    flush();
+    if (!out) {
+        throw std::runtime_error("Failed writing edge list: " + path);
+    }
+}
+
+#if defined(DSA_HAVE_MMAP)
+// Read-only memory map of a binary edge-list file. The records are used in place, so feeding them to
+// Graph::addEdges or the CsrGraph edge-list constructor needs no parsing and no intermediate copy; the
+// kernel pages the file in as the loader streams through it.
+class MappedEdgeList {
+public:
+    // The loaders make a few sequential passes over the records, hence the default readahead hint.
+    explicit MappedEdgeList(const std::string& path) : file(path, "edge list") {
+        if (file.size() % sizeof(EdgeRecord) != 0) {
+            throw std::runtime_error("Edge list is not a whole number of records: " + path);
+        }
+    }
+
+    const EdgeRecord* begin() const {
+        return reinterpret_cast<const EdgeRecord*>(file.data());
+    }
+
+    const EdgeRecord* end() const {
+        return begin() + size();
+    }
+
+    std::size_t size() const {
+        return file.size() / sizeof(EdgeRecord);
+    }
+
+private:
+    MappedFile file;
+};
+#endif
+
+// Binary min-heap of vertex IDs keyed by tentative distance, with a position index so decreaseKey finds
+// a queued vertex in O(1). This is the same handle bookkeeping MinMaxHeap uses in min_max_heap.cpp, with
+// dense vertex IDs serving as the handles; Dijkstra only ever needs the minimum end.
+class IndexedMinHeap {
+public:
+    explicit IndexedMinHeap(std::size_t vertexCount) : positions(vertexCount, kAbsent) {}
+
+    bool empty() const {
+        return entries.empty();
+    }
+
+    // Queues vertex with key, or lowers its key if it is already queued.
+    void pushOrDecrease(int vertex, double key) {
+        std::size_t& position = positions[static_cast<std::size_t>(vertex)];
+        if (position == kAbsent) {
+            position = entries.size();
+            entries.push_back({key, vertex});
+        } else {
+            entries[position].key = key;
+        }
+        siftUp(position);
+    }
+
+    int popMin() {
+        int vertex = entries.front().vertex;
+        positions[static_cast<std::size_t>(vertex)] = kAbsent;
+        Entry last = entries.back();
+        entries.pop_back();
+        if (!entries.empty()) {
+            entries[0] = last;
+            positions[static_cast<std::size_t>(last.vertex)] = 0;
+            siftDown(0);
+        }
+        return vertex;
+    }
+
+private:
+    static constexpr std::size_t kAbsent = static_cast<std::size_t>(-1);
+
+    // Keys sit next to their vertices so sifting compares entries without touching the distance array.
+    struct Entry {
+        double key;
+        int vertex;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<std::size_t> positions;
+
+    void place(std::size_t index, const Entry& entry) {
+        entries[index] = entry;
+        positions[static_cast<std::size_t>(entry.vertex)] = index;
+    }
+
+    void siftUp(std::size_t index) {
+        Entry moving = entries[index];
+        while (index > 0) {
+            std::size_t parent = (index - 1) / 2;
+            if (!(moving.key < entries[parent].key)) {
+                break;
+            }
+            place(index, entries[parent]);
+            index = parent;
+        }
+        place(index, moving);
+    }
+
+    void siftDown(std::size_t index) {
+        Entry moving = entries[index];
+        while (true) {
+            std::size_t child = 2 * index + 1;
+            if (child >= entries.size()) {
+                break;
+            }
+            if (child + 1 < entries.size() && entries[child + 1].key < entries[child].key) {
+                ++child;
+            }
+            if (!(entries[child].key < moving.key)) {
+                break;
+            }
+            place(index, entries[child]);
+            index = child;
+        }
+        place(index, moving);
+    }
 };
 
-int main() {
+// CsrGraph is an immutable snapshot of a Graph in compressed sparse row form. Vertices are renumbered
+// to dense IDs 0..n-1 in increasing order of their original labels; the neighbors of dense vertex v
+// are targets[offsets[v]] through targets[offsets[v + 1] - 1], in the order the edges were added.
+// Traversals then index flat arrays instead of hashing, and each neighbor list is one contiguous run.
+class CsrGraph {
+public:
+    enum class BfsStrategy {
+        TopDown,              // Classic frontier expansion: every frontier vertex scans all its edges.
+        DirectionOptimizing   // Switches to bottom-up steps while the frontier is large (Beamer et al.).
+    };
+
+    // Builds the CSR form straight from an edge list (std::pair<int, int> or EdgeRecord), never creating
+    // the hash-based Graph. The result is identical to CsrGraph(graph) for a Graph that received the same
+    // edges in order: one pass collects labels, one counts degrees, and one places every edge. When the
+    // labels span a range no wider than a few times the edge count, as dumps with dense IDs do, labels
+    // are renumbered through a flat array instead of sorting them.
+    template <typename EdgeIt>
+    CsrGraph(EdgeIt first, EdgeIt last) {
+        std::size_t endpoints = 0;
+        long long low = std::numeric_limits<int>::max();
+        long long high = std::numeric_limits<int>::min();
+        for (EdgeIt it = first; it != last; ++it) {
+            low = std::min<long long>(low, std::min<long long>(it->first, it->second));
+            high = std::max<long long>(high, std::max<long long>(it->first, it->second));
+            endpoints += 2;
+        }
+
+        std::vector<int> byLabel;
+        bool flat = endpoints > 0 && static_cast<unsigned long long>(high - low) < 4 * endpoints + 1024;
+        if (flat) {
+            byLabel.assign(static_cast<std::size_t>(high - low + 1), -1);
+            for (EdgeIt it = first; it != last; ++it) {
+                byLabel[static_cast<std::size_t>(it->first - low)] = 0;
+                byLabel[static_cast<std::size_t>(it->second - low)] = 0;
+            }
+            for (std::size_t offset = 0; offset < byLabel.size(); ++offset) {
+                if (byLabel[offset] == 0) {
+                    byLabel[offset] = static_cast<int>(originalIds.size());
+                    originalIds.push_back(static_cast<int>(low + static_cast<long long>(offset)));
+                }
+            }
+        } else {
+            originalIds.reserve(endpoints);
+            for (EdgeIt it = first; it != last; ++it) {
+                originalIds.push_back(it->first);
+                originalIds.push_back(it->second);
+            }
+            std::sort(originalIds.begin(), originalIds.end());
+            originalIds.erase(std::unique(originalIds.begin(), originalIds.end()), originalIds.end());
+        }
+        denseIds.reserve(originalIds.size());
+        for (std::size_t dense = 0; dense < originalIds.size(); ++dense) {
+            denseIds[originalIds[dense]] = static_cast<int>(dense);
+        }
+        auto dense = [&](int label) -> std::size_t {
+            return static_cast<std::size_t>(flat ? byLabel[static_cast<std::size_t>(label - low)] : denseIds.at(label));
+        };
+
+        offsets.assign(originalIds.size() + 1, 0);
+        for (EdgeIt it = first; it != last; ++it) {
+            ++offsets[dense(it->first) + 1];
+            ++offsets[dense(it->second) + 1];
+        }
+        for (std::size_t v = 0; v < originalIds.size(); ++v) {
+            offsets[v + 1] += offsets[v];
+        }
+        // cursor[v] is where vertex v's next neighbor goes; edges land in input order, as in Graph.
+        std::vector<std::size_t> cursor(offsets.begin(), offsets.end() - 1);
+        targets.resize(offsets.back());
+        for (EdgeIt it = first; it != last; ++it) {
+            std::size_t from = dense(it->first);
+            std::size_t to = dense(it->second);
+            targets[cursor[from]++] = static_cast<int>(to);
+            targets[cursor[to]++] = static_cast<int>(from);
+        }
+    }
+
+    explicit CsrGraph(const Graph& graph) {
+        originalIds.reserve(graph.adjacency.size());
+        for (const auto& entry : graph.adjacency) {
+            originalIds.push_back(entry.first);
+        }
+        std::sort(originalIds.begin(), originalIds.end());
+        denseIds.reserve(originalIds.size());
+        for (std::size_t dense = 0; dense < originalIds.size(); ++dense) {
+            denseIds[originalIds[dense]] = static_cast<int>(dense);
+        }
+
+        offsets.assign(originalIds.size() + 1, 0);
+        for (std::size_t dense = 0; dense < originalIds.size(); ++dense) {
+            offsets[dense + 1] = offsets[dense] + graph.adjacency.at(originalIds[dense]).size();
+        }
+        targets.reserve(offsets.back());
+        for (int original : originalIds) {
+            for (int neighbor : graph.adjacency.at(original)) {
+                targets.push_back(denseIds.at(neighbor));
+            }
+        }
+        if (graph.weighted) {
+            weights.reserve(offsets.back());
+            for (int original : originalIds) {
+                const auto& list = graph.weights.at(original);
+                weights.insert(weights.end(), list.begin(), list.end());
+            }
+        }
+    }
+
+    std::size_t vertexCount() const {
+        return originalIds.size();
+    }
+
+    // Directed edge count: each undirected edge from Graph::addEdge appears once per endpoint.
+    std::size_t edgeCount() const {
+        return targets.size();
+    }
+
+    int denseId(int original) const {
+        auto it = denseIds.find(original);
+        if (it == denseIds.end()) {
+            throw std::out_of_range("Vertex is not in the graph");
+        }
+        return it->second;
+    }
+
+    int originalId(int dense) const {
+        return originalIds[static_cast<std::size_t>(dense)];
+    }
+
+    // Returns the BFS depth of every vertex, indexed by dense ID, with -1 for unreachable vertices.
+    //
+    // Top-down steps cost the sum of the frontier's degrees. When the frontier is a large share of the
+    // graph, most of those edges lead to vertices that are already visited, so a bottom-up step is
+    // cheaper: every unvisited vertex scans its own neighbors and stops at the first one in the
+    // frontier. Following Beamer, Asanovic, and Patterson, BFS switches to bottom-up once the frontier's
+    // edges exceed 1/kAlpha of the edges still attached to unvisited vertices, and back to top-down once
+    // the frontier shrinks below 1/kBeta of all vertices.
+    std::vector<int> breadthFirstDepths(int start, BfsStrategy strategy = BfsStrategy::DirectionOptimizing) const {
+        const std::size_t n = vertexCount();
+        std::vector<int> depth(n, -1);
+        Bitset visited(n);
+        std::size_t source = static_cast<std::size_t>(denseId(start));
+        depth[source] = 0;
+        visited.set(source);
+
+        std::vector<int> frontier{static_cast<int>(source)};
+        std::vector<int> next;
+        Bitset frontierBits(n);
+        Bitset nextBits(n);
+        bool bottomUp = false;
+        std::size_t frontierSize = 1;
+        std::size_t frontierEdges = degree(source);
+        std::size_t unexploredEdges = edgeCount() - frontierEdges;
+
+        for (int level = 0; frontierSize > 0; ++level) {
+            if (strategy == BfsStrategy::DirectionOptimizing) {
+                if (!bottomUp && frontierEdges * kAlpha > unexploredEdges) {
+                    // Going bottom-up: turn the frontier queue into a bitmap.
+                    frontierBits.clear();
+                    for (int vertex : frontier) {
+                        frontierBits.set(static_cast<std::size_t>(vertex));
+                    }
+                    bottomUp = true;
+                } else if (bottomUp && frontierSize * kBeta < n) {
+                    // Going top-down again: collect the frontier bitmap back into a queue.
+                    frontier.clear();
+                    collectBits(frontierBits, frontier);
+                    bottomUp = false;
+                }
+            }
+
+            std::size_t nextSize = 0;
+            std::size_t nextEdges = 0;
+            if (bottomUp) {
+                nextBits.clear();
+                bottomUpStep(level, depth, visited, frontierBits, nextBits, nextSize, nextEdges);
+                std::swap(frontierBits, nextBits);
+            } else {
+                next.clear();
+                topDownStep(level, frontier, depth, visited, next, nextEdges);
+                nextSize = next.size();
+                std::swap(frontier, next);
+            }
+            frontierSize = nextSize;
+            frontierEdges = nextEdges;
+            unexploredEdges -= nextEdges;
+        }
+        return depth;
+    }
+
+    // Visitor traversals over the CSR arrays, reporting dense IDs in each TraversalStep. Everything they
+    // need is allocated once up front, sized by the vertex count: a visited bitmap plus a queue of steps
+    // for BFS, or a stack of (vertex, next edge) frames for DFS. Nothing is allocated per visited vertex,
+    // and a visitor that returns false ends the traversal immediately.
+    template <typename Visitor>
+    void visitBreadthFirst(int start, Visitor visit) const {
+        const std::size_t n = vertexCount();
+        Bitset visited(n);
+        std::vector<TraversalStep> queue(n);
+        std::size_t head = 0;
+        std::size_t tail = 0;
+        int source = denseId(start);
+        visited.set(static_cast<std::size_t>(source));
+        queue[tail++] = {source, -1, 0};
+        while (head < tail) {
+            TraversalStep step = queue[head++];
+            if (!continueAfter(visit, step)) {
+                return;
+            }
+            std::size_t v = static_cast<std::size_t>(step.vertex);
+            for (std::size_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+                std::size_t neighbor = static_cast<std::size_t>(targets[e]);
+                if (!visited.test(neighbor)) {
+                    visited.set(neighbor);
+                    queue[tail++] = {targets[e], step.vertex, step.depth + 1};
+                }
+            }
+        }
+    }
+
+    // Each frame's depth is its position on the stack and its parent is the frame below, so the frames
+    // only track where their edge scan resumes. Visits happen in the same preorder as Graph's DFS.
+    template <typename Visitor>
+    void visitDepthFirst(int start, Visitor visit) const {
+        struct Frame {
+            int vertex;
+            std::size_t nextEdge;
+        };
+        const std::size_t n = vertexCount();
+        Bitset visited(n);
+        std::vector<Frame> frames(n);
+        int source = denseId(start);
+        visited.set(static_cast<std::size_t>(source));
+        if (!continueAfter(visit, TraversalStep{source, -1, 0})) {
+            return;
+        }
+        frames[0] = {source, offsets[static_cast<std::size_t>(source)]};
+        std::size_t top = 1;
+        while (top > 0) {
+            Frame& frame = frames[top - 1];
+            if (frame.nextEdge == offsets[static_cast<std::size_t>(frame.vertex) + 1]) {
+                --top;
+                continue;
+            }
+            int neighbor = targets[frame.nextEdge++];
+            if (visited.test(static_cast<std::size_t>(neighbor))) {
+                continue;
+            }
+            visited.set(static_cast<std::size_t>(neighbor));
+            if (!continueAfter(visit, TraversalStep{neighbor, frame.vertex, static_cast<int>(top)})) {
+                return;
+            }
+            frames[top++] = {neighbor, offsets[static_cast<std::size_t>(neighbor)]};
+        }
+    }
+
+    // Level-synchronous top-down BFS on threadCount threads; returns the same depths as
+    // breadthFirstDepths. Threads pull 64-vertex chunks of the frontier from a shared cursor and claim
+    // each newly reached vertex with one fetch_or on the visited bitmap, so exactly one thread records
+    // its depth and appends it to that thread's own next-frontier buffer. The frontier is simply the
+    // set of per-thread buffers from the previous level, addressed through their prefix sums, so no
+    // level is ever copied into a shared queue.
+    std::vector<int> parallelBreadthFirstDepths(int start, unsigned threadCount) const {
+        const std::size_t n = vertexCount();
+        threadCount = std::max(1U, threadCount);
+        std::vector<int> depth(n, -1);
+        std::vector<std::atomic<std::uint64_t>> visited((n + 63) / 64);
+        for (auto& word : visited) {
+            word.store(0, std::memory_order_relaxed);
+        }
+        std::size_t source = static_cast<std::size_t>(denseId(start));
+        claim(visited, source);
+        depth[source] = 0;
+
+        std::vector<std::vector<int>> frontier(threadCount);
+        std::vector<std::vector<int>> next(threadCount);
+        frontier[0].push_back(static_cast<int>(source));
+        // frontierStarts[b] is the global frontier position of frontier[b][0].
+        std::vector<std::size_t> frontierStarts(threadCount + 1, 1);
+        frontierStarts[0] = 0;
+        std::atomic<std::size_t> cursor{0};
+        int level = 0;
+        bool finished = false;
+        Barrier barrier(threadCount);
+
+        runOnThreads(threadCount, [&](unsigned t) {
+            while (!finished) {
+                forEachClaimed(frontier, frontierStarts, cursor, [&](std::size_t v) {
+                    for (std::size_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+                        std::size_t neighbor = static_cast<std::size_t>(targets[e]);
+                        if (claim(visited, neighbor)) {
+                            depth[neighbor] = level + 1;
+                            next[t].push_back(targets[e]);
+                        }
+                    }
+                });
+                barrier.arriveAndWait([&] {
+                    // Serial step: the buffers just filled become the next frontier.
+                    std::swap(frontier, next);
+                    for (std::size_t b = 0; b < threadCount; ++b) {
+                        next[b].clear();
+                        frontierStarts[b + 1] = frontierStarts[b] + frontier[b].size();
+                    }
+                    cursor.store(0, std::memory_order_relaxed);
+                    ++level;
+                    finished = frontierStarts[threadCount] == 0;
+                });
+            }
+        });
+        return depth;
+    }
+
+    // Labels every vertex with the smallest dense ID in its connected component, using the
+    // Shiloach-Vishkin scheme as formulated in the GAP benchmark suite. Each round hooks: for every edge
+    // whose endpoints carry different labels, the larger label, if it is still a root, is pointed at
+    // the smaller one. It then shortcuts every label to its root by pointer jumping. Rounds repeat until
+    // no hook happens. Labels are relaxed atomics because hooks from different threads race benignly:
+    // a lost hook only means the edge is looked at again in the next round.
+    std::vector<int> parallelConnectedComponents(unsigned threadCount) const {
+        const std::size_t n = vertexCount();
+        threadCount = std::max(1U, threadCount);
+        std::vector<std::atomic<int>> labels(n);
+        for (std::size_t v = 0; v < n; ++v) {
+            labels[v].store(static_cast<int>(v), std::memory_order_relaxed);
+        }
+        std::atomic<std::size_t> cursor{0};
+        std::atomic<bool> changed{false};
+        bool hooking = true;
+        bool finished = n == 0;
+        Barrier barrier(threadCount);
+
+        runOnThreads(threadCount, [&](unsigned) {
+            while (!finished) {
+                std::size_t begin;
+                while ((begin = cursor.fetch_add(kChunk, std::memory_order_relaxed)) < n) {
+                    std::size_t end = std::min(begin + kChunk, n);
+                    for (std::size_t u = begin; u < end; ++u) {
+                        if (hooking) {
+                            hookEdges(labels, u, changed);
+                        } else {
+                            shortcut(labels, u);
+                        }
+                    }
+                }
+                barrier.arriveAndWait([&] {
+                    // Serial step: alternate phases, and stop after a shortcut that followed a quiet hook.
+                    cursor.store(0, std::memory_order_relaxed);
+                    if (!hooking) {
+                        finished = !changed.exchange(false, std::memory_order_relaxed);
+                    }
+                    hooking = !hooking;
+                });
+            }
+        });
+
+        std::vector<int> result(n);
+        for (std::size_t v = 0; v < n; ++v) {
+            result[v] = labels[v].load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    // Single-source shortest path distances by dense ID (infinity if unreachable), using Dijkstra's
+    // algorithm with decrease-key on an IndexedMinHeap, so the queue never holds more than one entry per
+    // vertex. Unweighted graphs use weight 1 for every edge.
+    std::vector<double> shortestPathDistances(int start) const {
+        const std::size_t n = vertexCount();
+        std::vector<double> distance(n, std::numeric_limits<double>::infinity());
+        IndexedMinHeap queue(n);
+        int source = denseId(start);
+        distance[static_cast<std::size_t>(source)] = 0;
+        queue.pushOrDecrease(source, 0);
+        while (!queue.empty()) {
+            std::size_t u = static_cast<std::size_t>(queue.popMin());
+            for (std::size_t e = offsets[u]; e < offsets[u + 1]; ++e) {
+                std::size_t v = static_cast<std::size_t>(targets[e]);
+                double candidate = distance[u] + edgeWeight(e);
+                if (candidate < distance[v]) {
+                    distance[v] = candidate;
+                    queue.pushOrDecrease(targets[e], candidate);
+                }
+            }
+        }
+        return distance;
+    }
+
+    // Parallel delta-stepping (Meyer and Sanders) in the simplified form of the GAP benchmark suite.
+    // Tentative distances are bucketed into ranges of width delta, and all vertices of the lowest
+    // non-empty bucket are relaxed in parallel. A relaxation that lowers a distance (an atomic min via
+    // compare-exchange) files the target into the bucket for its new distance in the relaxing thread's
+    // own bins. When the frontier is exhausted, the serial step picks the lowest bucket any thread has
+    // filled, possibly the same one again, and hands those per-thread bins over as the next frontier.
+    // A vertex whose distance has since dropped below its bucket was already relaxed from a lower one
+    // and is skipped. Small delta approaches Dijkstra's ordering; large delta approaches Bellman-Ford's
+    // parallelism, at the cost of relaxing edges repeatedly.
+    // While bucket b is processed every pending vertex lies in buckets b .. b + maxWeight / delta + 1,
+    // so each thread's bins form a ring indexed by bucket modulo its size: maxWeight / delta + 3 slots
+    // (one spare for rounding), at most kMaxRingSlots. The ring is the memory and serial-scan cost of
+    // delta, up to that many vectors per thread. A delta below about maxWeight / kMaxRingSlots makes
+    // buckets share slots; vertices are then sometimes relaxed before their turn, which stays correct
+    // because any later improvement files them again, but repeats work. Weights must be finite, and
+    // n * maxWeight / delta, a bound on any bucket index, must fit comfortably in a size_t.
+    std::vector<double> parallelShortestPathDistances(int start, double delta, unsigned threadCount) const {
+        if (!(delta > 0) || !std::isfinite(delta)) {
+            throw std::invalid_argument("delta must be positive and finite");
+        }
+        const std::size_t n = vertexCount();
+        double maxWeight = weights.empty() && !targets.empty() ? 1.0 : 0.0;
+        for (double weight : weights) {
+            if (!std::isfinite(weight)) {
+                throw std::invalid_argument("Delta-stepping needs finite edge weights");
+            }
+            maxWeight = std::max(maxWeight, weight);
+        }
+        // A tentative distance is the length of a simple path, at most n * maxWeight, so checking that
+        // bound here keeps every candidate / delta below kMaxBucket before it is cast to a bucket index.
+        const double kMaxBucket = static_cast<double>(std::numeric_limits<std::size_t>::max() / 4);
+        if (!(static_cast<double>(n) * maxWeight / delta < kMaxBucket)) {
+            throw std::invalid_argument("delta is too small for these edge weights");
+        }
+        const double liveBuckets = maxWeight / delta + 3;
+        const std::size_t ringSize = liveBuckets < static_cast<double>(kMaxRingSlots)
+                                         ? static_cast<std::size_t>(liveBuckets)
+                                         : kMaxRingSlots;
+        threadCount = std::max(1U, threadCount);
+        std::vector<std::atomic<double>> distance(n);
+        for (auto& value : distance) {
+            value.store(std::numeric_limits<double>::infinity(), std::memory_order_relaxed);
+        }
+        int source = denseId(start);
+        distance[static_cast<std::size_t>(source)].store(0, std::memory_order_relaxed);
+
+        // bins[t][b % ringSize] holds the vertices thread t filed into bucket b, and highest[t] is the
+        // largest bucket it has filed into. The serial step scans at most one lap of the ring past the
+        // current bucket, which visits every slot once.
+        std::vector<std::vector<std::vector<int>>> bins(threadCount);
+        std::vector<std::size_t> highest(threadCount, 0);
+        std::vector<std::vector<int>> frontier(threadCount);
+        frontier[0].push_back(source);
+        std::vector<std::size_t> frontierStarts(threadCount + 1, 1);
+        frontierStarts[0] = 0;
+        std::atomic<std::size_t> cursor{0};
+        std::size_t bucket = 0;
+        bool finished = false;
+        Barrier barrier(threadCount);
+
+        runOnThreads(threadCount, [&](unsigned t) {
+            std::vector<std::vector<int>>& myBins = bins[t];
+            while (!finished) {
+                double bucketStart = delta * static_cast<double>(bucket);
+                forEachClaimed(frontier, frontierStarts, cursor, [&](std::size_t u) {
+                    double base = distance[u].load(std::memory_order_relaxed);
+                    if (base < bucketStart) {
+                        return;
+                    }
+                    for (std::size_t e = offsets[u]; e < offsets[u + 1]; ++e) {
+                        double candidate = base + edgeWeight(e);
+                        std::atomic<double>& target = distance[static_cast<std::size_t>(targets[e])];
+                        double current = target.load(std::memory_order_relaxed);
+                        while (candidate < current &&
+                               !target.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {
+                        }
+                        if (candidate < current) {
+                            // Clamped because rounding in candidate / delta must never file below the current bucket.
+                            std::size_t destination = std::max(bucket, static_cast<std::size_t>(candidate / delta));
+                            std::size_t slot = destination % ringSize;
+                            if (slot >= myBins.size()) {
+                                myBins.resize(slot + 1);
+                            }
+                            myBins[slot].push_back(targets[e]);
+                            highest[t] = std::max(highest[t], destination);
+                        }
+                    }
+                });
+                barrier.arriveAndWait([&] {
+                    // Serial step: find the lowest non-empty bucket and move its bins into the frontier.
+                    std::size_t nextBucket = std::numeric_limits<std::size_t>::max();
+                    for (unsigned owner = 0; owner < threadCount; ++owner) {
+                        const auto& threadBins = bins[owner];
+                        std::size_t last = std::min(highest[owner], bucket + ringSize - 1);
+                        for (std::size_t b = bucket; b <= last && b < nextBucket; ++b) {
+                            std::size_t slot = b % ringSize;
+                            if (slot < threadBins.size() && !threadBins[slot].empty()) {
+                                nextBucket = b;
+                            }
+                        }
+                    }
+                    finished = nextBucket == std::numeric_limits<std::size_t>::max();
+                    for (std::size_t b = 0; b < threadCount; ++b) {
+                        frontier[b].clear();
+                        if (!finished && nextBucket % ringSize < bins[b].size()) {
+                            std::swap(frontier[b], bins[b][nextBucket % ringSize]);
+                        }
+                        frontierStarts[b + 1] = frontierStarts[b] + frontier[b].size();
+                    }
+                    cursor.store(0, std::memory_order_relaxed);
+                    bucket = nextBucket;
+                });
+            }
+        });
+
+        std::vector<double> result(n);
+        for (std::size_t v = 0; v < n; ++v) {
+            result[v] = distance[v].load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+private:
+    static constexpr std::size_t kAlpha = 15;
+    static constexpr std::size_t kBeta = 18;
+    static constexpr std::size_t kChunk = 64;
+    // Upper bound on the delta-stepping bucket ring, per thread.
+    static constexpr std::size_t kMaxRingSlots = std::size_t(1) << 20;
+
+    std::vector<int> originalIds;
+    std::unordered_map<int, int> denseIds;
+    std::vector<std::size_t> offsets;
+    std::vector<int> targets;
+    // Parallel to targets; empty for an unweighted graph, where every edge weighs 1.
+    std::vector<double> weights;
+
+    double edgeWeight(std::size_t edge) const {
+        return weights.empty() ? 1.0 : weights[edge];
+    }
+
+    std::size_t degree(std::size_t vertex) const {
+        return offsets[vertex + 1] - offsets[vertex];
+    }
+
+    void topDownStep(int level, const std::vector<int>& frontier, std::vector<int>& depth, Bitset& visited,
+                     std::vector<int>& next, std::size_t& nextEdges) const {
+        for (int vertex : frontier) {
+            std::size_t v = static_cast<std::size_t>(vertex);
+            for (std::size_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+                std::size_t neighbor = static_cast<std::size_t>(targets[e]);
+                if (!visited.test(neighbor)) {
+                    visited.set(neighbor);
+                    depth[neighbor] = level + 1;
+                    next.push_back(targets[e]);
+                    nextEdges += degree(neighbor);
+                }
+            }
+        }
+    }
+
+    // Walks the unvisited vertices one 64-bit word at a time, so fully visited regions are skipped
+    // with a single comparison.
+    void bottomUpStep(int level, std::vector<int>& depth, Bitset& visited, const Bitset& frontierBits,
+                      Bitset& nextBits, std::size_t& nextSize, std::size_t& nextEdges) const {
+        const std::size_t n = vertexCount();
+        for (std::size_t w = 0; w < visited.wordCount(); ++w) {
+            std::uint64_t unvisited = ~visited.word(w);
+            while (unvisited != 0) {
+                std::size_t v = w * 64 + static_cast<std::size_t>(lowestBit(unvisited));
+                unvisited &= unvisited - 1;
+                if (v >= n) {
+                    break;
+                }
+                for (std::size_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+                    if (frontierBits.test(static_cast<std::size_t>(targets[e]))) {
+                        // One parent in the frontier is enough; the remaining edges are never read.
+                        visited.set(v);
+                        nextBits.set(v);
+                        depth[v] = level + 1;
+                        ++nextSize;
+                        nextEdges += degree(v);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // Hands out kChunk-sized runs of a frontier that is stored as several buffers, addressed through
+    // their prefix sums in starts, to whichever thread asks next, and calls visit(vertex) for every
+    // vertex in the runs this thread wins.
+    template <typename Visit>
+    static void forEachClaimed(const std::vector<std::vector<int>>& buffers, const std::vector<std::size_t>& starts,
+                               std::atomic<std::size_t>& cursor, Visit visit) {
+        std::size_t total = starts.back();
+        std::size_t begin;
+        while ((begin = cursor.fetch_add(kChunk, std::memory_order_relaxed)) < total) {
+            std::size_t end = std::min(begin + kChunk, total);
+            std::size_t buffer =
+                static_cast<std::size_t>(std::upper_bound(starts.begin(), starts.end(), begin) - starts.begin() - 1);
+            for (std::size_t position = begin; position < end; ++position) {
+                while (position >= starts[buffer + 1]) {
+                    ++buffer;
+                }
+                visit(static_cast<std::size_t>(buffers[buffer][position - starts[buffer]]));
+            }
+        }
+    }
+
+    // Sets the vertex's bit and reports whether this call was the one that set it. The plain load first
+    // skips the read-modify-write for the common case of an already visited vertex.
+    static bool claim(std::vector<std::atomic<std::uint64_t>>& bits, std::size_t vertex) {
+        std::uint64_t mask = std::uint64_t(1) << (vertex & 63);
+        std::atomic<std::uint64_t>& word = bits[vertex >> 6];
+        if (word.load(std::memory_order_relaxed) & mask) {
+            return false;
+        }
+        return (word.fetch_or(mask, std::memory_order_relaxed) & mask) == 0;
+    }
+
+    void hookEdges(std::vector<std::atomic<int>>& labels, std::size_t u, std::atomic<bool>& changed) const {
+        for (std::size_t e = offsets[u]; e < offsets[u + 1]; ++e) {
+            int labelU = labels[u].load(std::memory_order_relaxed);
+            int labelV = labels[static_cast<std::size_t>(targets[e])].load(std::memory_order_relaxed);
+            if (labelU == labelV) {
+                continue;
+            }
+            int high = std::max(labelU, labelV);
+            int low = std::min(labelU, labelV);
+            std::atomic<int>& root = labels[static_cast<std::size_t>(high)];
+            if (root.load(std::memory_order_relaxed) == high) {
+                root.store(low, std::memory_order_relaxed);
+                changed.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static void shortcut(std::vector<std::atomic<int>>& labels, std::size_t u) {
+        int label = labels[u].load(std::memory_order_relaxed);
+        int parent = labels[static_cast<std::size_t>(label)].load(std::memory_order_relaxed);
+        while (label != parent) {
+            label = parent;
+            parent = labels[static_cast<std::size_t>(label)].load(std::memory_order_relaxed);
+        }
+        labels[u].store(label, std::memory_order_relaxed);
+    }
+
+    static void collectBits(const Bitset& bits, std::vector<int>& out) {
+        for (std::size_t w = 0; w < bits.wordCount(); ++w) {
+            std::uint64_t word = bits.word(w);
+            while (word != 0) {
+                out.push_back(static_cast<int>(w * 64 + static_cast<std::size_t>(lowestBit(word))));
+                word &= word - 1;
+            }
+        }
+    }
+};
+
+// Builds a random graph with the given number of vertices and undirected edges, freezes it, and times
+// the original hash-based BFS against top-down and direction-optimizing BFS over CSR, then the parallel
+// BFS and connected components at several thread counts.
+void runTraversalBenchmark() {
+    const int vertices = 1 << 20;
+    const int edges = 8 * vertices;
+    Graph graph;
+    bench::Rng rng(7);
+    for (int i = 0; i < edges; ++i) {
+        graph.addEdge(static_cast<int>(rng.below(vertices)), static_cast<int>(rng.below(vertices)));
+    }
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    auto start = std::chrono::steady_clock::now();
+    CsrGraph csr(graph);
+    auto frozen = std::chrono::steady_clock::now();
+    std::cout << "Traversal benchmark: " << csr.vertexCount() << " vertices, " << csr.edgeCount()
+              << " directed edges (CSR build " << ms(start, frozen) << " ms)\n";
+    bench::record("CSR build ms", ms(start, frozen));
+
+    // The hash-based BFS prints every vertex, so its output is discarded while it runs.
+    int source = csr.originalId(0);
+    std::streambuf* console = std::cout.rdbuf(nullptr);
+    start = std::chrono::steady_clock::now();
+    graph.breadthFirstSearch(source);
+    auto hashed = std::chrono::steady_clock::now();
+    std::cout.rdbuf(console);
+    std::cout.clear();
+
+    auto begin = hashed;
+    std::vector<int> topDown = csr.breadthFirstDepths(source, CsrGraph::BfsStrategy::TopDown);
+    auto csrTopDown = std::chrono::steady_clock::now();
+    std::vector<int> optimized = csr.breadthFirstDepths(source);
+    auto csrOptimized = std::chrono::steady_clock::now();
+    std::cout << "hash-map BFS " << ms(start, hashed) << " ms, CSR top-down " << ms(hashed, csrTopDown)
+              << " ms, CSR direction-optimizing " << ms(csrTopDown, csrOptimized) << " ms (depths "
+              << (topDown == optimized ? "match" : "differ") << ")\n";
+    bench::record("hash-map BFS ms", ms(start, hashed));
+    bench::record("CSR top-down BFS ms", ms(hashed, csrTopDown));
+    bench::record("CSR direction-optimizing BFS ms", ms(csrTopDown, csrOptimized));
+
+    // Visitors replace the printing loop: the same traversal order with no formatted output inside it.
+    long long depthSum = 0;
+    begin = std::chrono::steady_clock::now();
+    graph.visitBreadthFirst(source, [&depthSum](const TraversalStep& step) { depthSum += step.depth; });
+    auto hashVisited = std::chrono::steady_clock::now();
+    csr.visitBreadthFirst(source, [&depthSum](const TraversalStep& step) { depthSum -= step.depth; });
+    auto csrVisited = std::chrono::steady_clock::now();
+    std::cout << "visitor BFS: hash-map " << ms(begin, hashVisited) << " ms, CSR " << ms(hashVisited, csrVisited)
+              << " ms (depth sums " << (depthSum == 0 ? "match" : "differ") << ")\n";
+    bench::record("hash-map visitor BFS ms", ms(begin, hashVisited));
+    bench::record("CSR visitor BFS ms", ms(hashVisited, csrVisited));
+
+    std::cout << "Parallel traversals (" << std::thread::hardware_concurrency() << " hardware threads):\n";
+    for (unsigned threads : {1U, 2U, 4U, 8U}) {
+        begin = std::chrono::steady_clock::now();
+        std::vector<int> parallel = csr.parallelBreadthFirstDepths(source, threads);
+        auto searched = std::chrono::steady_clock::now();
+        std::vector<int> labels = csr.parallelConnectedComponents(threads);
+        auto labeled = std::chrono::steady_clock::now();
+        std::size_t components = 0;
+        for (std::size_t v = 0; v < labels.size(); ++v) {
+            components += labels[v] == static_cast<int>(v) ? 1 : 0;
+        }
+        std::cout << "  " << threads << " threads: BFS " << ms(begin, searched) << " ms (depths "
+                  << (parallel == topDown ? "match" : "differ") << "), components " << ms(searched, labeled)
+                  << " ms (" << components << " components)\n";
+        bench::record("parallel BFS " + std::to_string(threads) + " threads ms", ms(begin, searched));
+        bench::record("components " + std::to_string(threads) + " threads ms", ms(searched, labeled));
+    }
+}
+
+// Routes over a random road-like graph with integer weights, so every algorithm's distances are exact
+// and can be compared for equality.
+void runShortestPathBenchmark() {
+    const int vertices = 1 << 20;
+    const int edges = 4 * vertices;
+    Graph graph;
+    bench::Rng rng(11);
+    for (int i = 0; i < edges; ++i) {
+        graph.addEdge(static_cast<int>(rng.below(vertices)), static_cast<int>(rng.below(vertices)),
+                      static_cast<double>(1 + rng.below(100)));
+    }
+    CsrGraph csr(graph);
+    int source = csr.originalId(0);
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::cout << "Shortest path benchmark: " << csr.vertexCount() << " vertices, " << csr.edgeCount()
+              << " directed edges, weights 1-100\n";
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<double> dijkstra = csr.shortestPathDistances(source);
+    auto finished = std::chrono::steady_clock::now();
+    std::cout << "  Dijkstra " << ms(start, finished) << " ms\n";
+    bench::record("Dijkstra ms", ms(start, finished));
+    for (double delta : {10.0, 50.0}) {
+        for (unsigned threads : {1U, 2U, 4U, 8U}) {
+            start = std::chrono::steady_clock::now();
+            std::vector<double> stepped = csr.parallelShortestPathDistances(source, delta, threads);
+            finished = std::chrono::steady_clock::now();
+            std::cout << "  delta-stepping (delta " << delta << ", " << threads << " threads) " << ms(start, finished)
+                      << " ms (distances " << (stepped == dijkstra ? "match" : "differ") << ")\n";
+            bench::record("delta-stepping delta " + std::to_string(static_cast<int>(delta)) + " " +
+                              std::to_string(threads) + " threads ms",
+                          ms(start, finished));
+        }
+    }
+}
+
+#if defined(DSA_HAVE_MMAP)
+// Loads the same random edge dump several ways: addEdge per edge, addEdges from memory, and from a
+// memory-mapped file into either representation.
+void runLoadBenchmark() {
+    const int vertices = 1 << 20;
+    const std::size_t edgeCount = std::size_t(8) << 20;
+    const std::string path = "graph_bench.edges";
+    std::vector<std::pair<int, int>> edges(edgeCount);
+    bench::Rng rng(19);
+    for (auto& edge : edges) {
+        edge = {static_cast<int>(rng.below(vertices)), static_cast<int>(rng.below(vertices))};
+    }
+    writeEdgeList(edges.begin(), edges.end(), path);
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::cout << "Load benchmark: " << edgeCount << " edges over " << vertices << " labels\n";
+
+    auto start = std::chrono::steady_clock::now();
+    Graph oneByOne;
+    for (const auto& edge : edges) {
+        oneByOne.addEdge(edge.first, edge.second);
+    }
+    auto single = std::chrono::steady_clock::now();
+    Graph batched;
+    batched.addEdges(edges);
+    auto batch = std::chrono::steady_clock::now();
+    std::cout << "  in memory: addEdge " << ms(start, single) << " ms, addEdges " << ms(single, batch) << " ms\n";
+    bench::record("addEdge ms", ms(start, single));
+    bench::record("addEdges ms", ms(single, batch));
+
+    start = std::chrono::steady_clock::now();
+    std::size_t mappedEdges = 0;
+    {
+        MappedEdgeList mapped(path);
+        Graph loaded;
+        loaded.addEdges(mapped.begin(), mapped.end());
+        mappedEdges = mapped.size();
+    }
+    auto mappedGraph = std::chrono::steady_clock::now();
+    std::size_t directedEdges = 0;
+    {
+        MappedEdgeList mapped(path);
+        CsrGraph csr(mapped.begin(), mapped.end());
+        directedEdges = csr.edgeCount();
+    }
+    auto mappedCsr = std::chrono::steady_clock::now();
+    CsrGraph frozen(batched);
+    auto frozenCsr = std::chrono::steady_clock::now();
+    std::cout << "  from mmap: Graph " << ms(start, mappedGraph) << " ms, CSR directly " << ms(mappedGraph, mappedCsr)
+              << " ms (" << mappedEdges << " records, " << directedEdges << " directed edges); freezing the Graph "
+              << "instead takes " << ms(mappedCsr, frozenCsr) << " ms more\n";
+    bench::record("mmap to Graph ms", ms(start, mappedGraph));
+    bench::record("mmap to CSR ms", ms(mappedGraph, mappedCsr));
+    bench::record("freeze Graph to CSR ms", ms(mappedCsr, frozenCsr));
+    std::remove(path.c_str());
+}
+#endif
+
+int main(int argc, char* argv[]) {
     Graph graph;
     // Build a small binary-like adjacency structure to illustrate how DFS and BFS diverge.
     graph.addEdge(1, 2);
@@ -100,5 +1311,63 @@ int main() {
     graph.depthFirstSearch(1);
     graph.breadthFirstSearch(1);
 
+    // Freezing the graph renumbers vertices densely; depths come back indexed by those dense IDs.
+    CsrGraph csr(graph);
+    std::vector<int> depths = csr.breadthFirstDepths(1);
+    std::cout << "CSR BFS depths:";
+    for (std::size_t dense = 0; dense < depths.size(); ++dense) {
+        std::cout << ' ' << csr.originalId(static_cast<int>(dense)) << '=' << depths[dense];
+    }
+    std::cout << "\n";
+
+    // A visitor can stop as soon as it sees its target and still report how it got there.
+    graph.visitBreadthFirst(1, [](const TraversalStep& step) {
+        if (step.vertex != 6) {
+            return true;
+        }
+        std::cout << "Found 6 at depth " << step.depth << " via " << step.parent << "\n";
+        return false;
+    });
+
+    std::vector<int> labels = csr.parallelConnectedComponents(2);
+    std::cout << "Parallel BFS agrees: " << (csr.parallelBreadthFirstDepths(1, 2) == depths ? "yes" : "no")
+              << ", component of vertex 7 is labeled "
+              << csr.originalId(labels[static_cast<std::size_t>(csr.denseId(7))]) << "\n";
+
+    // Weighted routing: the direct edge 1-7 is longer than the detour through 3.
+    Graph roads;
+    roads.addEdge(1, 3, 2.0);
+    roads.addEdge(3, 7, 1.5);
+    roads.addEdge(1, 7, 5.0);
+    roads.addEdge(7, 9, 1.0);
+    CsrGraph routes(roads);
+    std::vector<double> distances = routes.shortestPathDistances(1);
+    std::vector<double> stepped = routes.parallelShortestPathDistances(1, 1.0, 2);
+    std::cout << "Distance 1 -> 9: " << distances[static_cast<std::size_t>(routes.denseId(9))]
+              << " (delta-stepping " << stepped[static_cast<std::size_t>(routes.denseId(9))] << ")\n";
+
+#if defined(DSA_HAVE_MMAP)
+    // A binary edge dump loads straight into CSR form without building the hash-based Graph first.
+    std::vector<std::pair<int, int>> dump = {{1, 2}, {1, 3}, {2, 4}, {2, 5}, {3, 6}, {3, 7}};
+    writeEdgeList(dump.begin(), dump.end(), "graph_demo.edges");
+    {
+        MappedEdgeList mapped("graph_demo.edges");
+        CsrGraph loaded(mapped.begin(), mapped.end());
+        std::cout << "Loaded " << mapped.size() << " edges from disk; BFS depths "
+                  << (loaded.breadthFirstDepths(1) == csr.breadthFirstDepths(1) ? "match" : "differ") << "\n";
+    }
+    std::remove("graph_demo.edges");
+#endif
+
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("graph_traversal", argc, argv);
+        suite.run("traversal", runTraversalBenchmark);
+        suite.run("shortest_path", runShortestPathBenchmark);
+#if defined(DSA_HAVE_MMAP)
+        suite.run("load", runLoadBenchmark);
+#endif
+        return suite.finish();
+    }
+
     return 0;
 }
@@ -1,72 +1,218 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-// This program implements a hash map keyed by integers and backed by an open-addressed table
-// with linear probing. Load factor is kept under 60% by rehashing into a larger table, which
-// preserves O(1) average insert, lookup, and removal while avoiding excessive clustering.
+#include "bench_harness.h"
+#include "mapped_file.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HASH_MAP_USE_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HASH_MAP_USE_NEON 1
+#endif
+
+// This program implements a generic hash map backed by an open-addressed table with linear
+// probing. Load factor is kept under 60% by rehashing into a larger table, which preserves
+// O(1) average insert, lookup, and removal while avoiding excessive clustering. Keys and values
+// are stored inline in the buckets, so both types must be default-constructible.
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
 class HashMap {
 public:
-    explicit HashMap(std::size_t initialCapacity = 8) {
+    enum class ResizePolicy {
+        // Move every entry into the doubled table inside the put() that crosses the threshold.
+        AllAtOnce,
+        // Keep the old table alongside the new one and migrate a few slots per operation, so no
+        // single put() pays for the whole rehash. The cost is spread rather than removed: median and
+        // p99.9 puts get slower, mostly from paging in the next table a few buckets at a time, while
+        // the worst put drops from tens of milliseconds to a few.
+        Incremental
+    };
+
+    enum class DeletionPolicy {
+        // Leave a Deleted tombstone; once tombstones pass 20% of the table it is compacted in place.
+        Tombstone,
+        // Pull later members of the probe cluster back into the hole, so the table never holds tombstones.
+        BackwardShift
+    };
+
+    // Counters describing how much probing the table does and how much of it the deletion policy saves.
+    struct ProbeStats {
+        // Slots examined by lookups and inserts.
+        std::size_t probes = 0;
+        // Examined slots that were tombstones, i.e. probe work spent stepping over deleted entries.
+        std::size_t tombstoneProbes = 0;
+        // In-place compactions triggered by the tombstone ratio, and the tombstones they cleared.
+        std::size_t compactions = 0;
+        std::size_t tombstonesCleared = 0;
+        // Entries moved back by backward-shift deletion instead of leaving a tombstone behind.
+        std::size_t shiftedEntries = 0;
+    };
+
+    explicit HashMap(std::size_t initialCapacity = 8, ResizePolicy policy = ResizePolicy::AllAtOnce,
+                     DeletionPolicy deletion = DeletionPolicy::Tombstone)
+        : resizePolicy(policy), deletionPolicy(deletion) {
         if (initialCapacity < 8) {
             initialCapacity = 8;
         }
         // Buckets form the underlying fixed-size array for open addressing; each element
         // records a state flag so we can distinguish empty, occupied, and deleted slots.
-        buckets.resize(initialCapacity);
+        buckets.growTo(initialCapacity);
     }
 
-    void put(int key, const std::string& value) {
-        // Growing before insertion keeps the load factor in the safe range for linear probing.
-        ensureCapacity(count + 1);
-        insertInternal(key, value);
+    // put inserts or overwrites; rvalue keys and values are moved into the bucket rather than copied.
+    template <typename V>
+    void put(const Key& key, V&& value) {
+        insertInternal(key, true, std::forward<V>(value));
     }
 
-    bool get(int key, std::string& value) const {
-        const Bucket* bucket = findBucket(key);
-        if (!bucket) {
+    template <typename V>
+    void put(Key&& key, V&& value) {
+        insertInternal(std::move(key), true, std::forward<V>(value));
+    }
+
+    // emplace builds the value from args and stores it under key, replacing any existing value.
+    template <typename... Args>
+    Value& emplace(const Key& key, Args&&... args) {
+        return *insertInternal(key, true, std::forward<Args>(args)...).first;
+    }
+
+    template <typename... Args>
+    Value& emplace(Key&& key, Args&&... args) {
+        return *insertInternal(std::move(key), true, std::forward<Args>(args)...).first;
+    }
+
+    // tryEmplace leaves an existing entry untouched and never constructs a value for it; the bool
+    // reports whether a new entry was inserted.
+    template <typename... Args>
+    std::pair<Value*, bool> tryEmplace(const Key& key, Args&&... args) {
+        return insertInternal(key, false, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    std::pair<Value*, bool> tryEmplace(Key&& key, Args&&... args) {
+        return insertInternal(std::move(key), false, std::forward<Args>(args)...);
+    }
+
+    bool get(const Key& key, Value& value) const {
+        const Value* found = find(key);
+        if (!found) {
             return false;
         }
-        value = bucket->value;
+        value = *found;
         return true;
     }
 
-    bool contains(int key) const {
-        return findBucket(key) != nullptr;
+    Value* find(const Key& key) {
+        return findValue(key);
     }
 
-    bool remove(int key) {
-        if (buckets.empty()) {
-            return false;
-        }
-        std::size_t index = indexFor(key);
-        std::size_t start = index;
-        while (true) {
-            Bucket& bucket = buckets[index];
-            if (bucket.state == State::Empty) {
-                // Encountering a never-used slot means the key does not exist in the table.
-                return false;
-            }
-            if (bucket.state == State::Occupied && bucket.key == key) {
+    const Value* find(const Key& key) const {
+        return findValue(key);
+    }
+
+    // When both Hash and KeyEqual declare is_transparent, lookups accept any comparable type (for
+    // example std::string_view against std::string keys) without building a temporary Key.
+    template <typename K, typename H = Hash, typename E = KeyEqual, typename = typename H::is_transparent,
+              typename = typename E::is_transparent>
+    Value* find(const K& key) {
+        return findValue(key);
+    }
+
+    template <typename K, typename H = Hash, typename E = KeyEqual, typename = typename H::is_transparent,
+              typename = typename E::is_transparent>
+    const Value* find(const K& key) const {
+        return findValue(key);
+    }
+
+    bool contains(const Key& key) const {
+        return findValue(key) != nullptr;
+    }
+
+    template <typename K, typename H = Hash, typename E = KeyEqual, typename = typename H::is_transparent,
+              typename = typename E::is_transparent>
+    bool contains(const K& key) const {
+        return findValue(key) != nullptr;
+    }
+
+    bool remove(const Key& key) {
+        migrateStep();
+        std::size_t index = findSlot(buckets, key, 0);
+        if (index != kNotFound) {
+            if (deletionPolicy == DeletionPolicy::BackwardShift) {
+                backwardShiftDelete(index);
+            } else {
                 // Mark the slot as deleted to keep probing chains intact for other keys.
-                bucket.state = State::Deleted;
-                bucket.value.clear();
-                --count;
-                return true;
-            }
-            index = (index + 1) % buckets.size();
-            if (index == start) {
-                return false;
+                clearBucket(buckets[index], State::Deleted);
+                ++tombstones;
+                compactIfNeeded();
             }
+            --count;
+            return true;
         }
+        if (Bucket* bucket = probeRetiring(key)) {
+            // The retiring table always uses tombstones because the migration cursor relies on entries
+            // never moving backwards past it.
+            clearBucket(*bucket, State::Deleted);
+            --retiringLive;
+            --count;
+            return true;
+        }
+        return false;
     }
 
     std::size_t size() const {
         return count;
     }
 
+    const ProbeStats& stats() const {
+        return probeStats;
+    }
+
+    // Inserts and lookups bump the probe counters, lookups from const methods; turning counting off
+    // stops both and makes get()/contains() purely read-only, so several threads may call them at once
+    // (with the default AllAtOnce policy).
+    void setProbeCounting(bool enabled) {
+        probeCounting = enabled;
+    }
+
+    bool migrating() const {
+        return !retiring.empty();
+    }
+
+    // forEach visits every live entry as (key, value), including entries not yet migrated.
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (std::size_t i = 0; i < buckets.size(); ++i) {
+            if (buckets[i].state == State::Occupied) {
+                visit(buckets[i].key, buckets[i].value);
+            }
+        }
+        // Retiring slots below the cursor have already moved, and their chunks may be released.
+        for (std::size_t i = migrationCursor; i < retiring.size(); ++i) {
+            if (retiring[i].state == State::Occupied) {
+                visit(retiring[i].key, retiring[i].value);
+            }
+        }
+    }
+
 private:
     enum class State {
         Empty,
@@ -76,17 +222,154 @@ private:
 
     struct Bucket {
         // key/value store the entry payload; state tracks whether the slot is free, occupied, or a tombstone.
-        int key = 0;
-        std::string value;
+        Key key = Key();
+        Value value = Value();
         State state = State::Empty;
     };
 
-    std::vector<Bucket> buckets;
+    // The tables store their buckets in fixed-size chunks rather than one array. Indexing costs one extra
+    // load from a small, always-cached chunk directory, and in return a retiring table can give its memory
+    // back a chunk at a time as the migration cursor passes, instead of destroying and freeing millions of
+    // buckets inside whichever put() finishes the migration.
+    class BucketTable {
+    public:
+        static constexpr std::size_t kChunkShift = 10;
+        static constexpr std::size_t kChunkSize = std::size_t(1) << kChunkShift;
+        // Retired chunks, kept whole so the next table reuses memory that is already paged in instead of
+        // faulting fresh pages on the put() path. Every pooled bucket holds a default key and value.
+        using ChunkPool = std::vector<std::vector<Bucket>>;
+
+        BucketTable() = default;
+
+        explicit BucketTable(std::size_t capacity) {
+            growTo(capacity);
+        }
+
+        BucketTable(const BucketTable&) = default;
+        BucketTable& operator=(const BucketTable&) = default;
+
+        // Moving hands over the chunks and leaves the source empty. The defaulted moves would keep the
+        // source's bucketCount with no chunks behind it, so its next operator[] dereferences nothing.
+        BucketTable(BucketTable&& other) noexcept
+            : chunks(std::move(other.chunks)),
+              bucketCount(std::exchange(other.bucketCount, 0)),
+              releasedChunks(std::exchange(other.releasedChunks, 0)) {
+            other.chunks.clear();
+        }
+
+        BucketTable& operator=(BucketTable&& other) noexcept {
+            if (this != &other) {
+                chunks = std::move(other.chunks);
+                other.chunks.clear();
+                bucketCount = std::exchange(other.bucketCount, 0);
+                releasedChunks = std::exchange(other.releasedChunks, 0);
+            }
+            return *this;
+        }
+
+        std::size_t size() const {
+            return bucketCount;
+        }
+
+        bool empty() const {
+            return bucketCount == 0;
+        }
+
+        Bucket& operator[](std::size_t index) {
+            return chunks[index >> kChunkShift][index & (kChunkSize - 1)];
+        }
+
+        const Bucket& operator[](std::size_t index) const {
+            return chunks[index >> kChunkShift][index & (kChunkSize - 1)];
+        }
+
+        // Value-initializes buckets up to capacity. Each chunk reserves its full size when first touched,
+        // or reuses a pooled chunk, whose buckets then only need their state reset; either way growing
+        // never relocates existing buckets.
+        void growTo(std::size_t capacity, ChunkPool* pool = nullptr) {
+            while (bucketCount < capacity) {
+                std::size_t chunk = bucketCount >> kChunkShift;
+                if (chunk == chunks.size()) {
+                    if (pool && !pool->empty()) {
+                        chunks.push_back(std::move(pool->back()));
+                        pool->pop_back();
+                    } else {
+                        chunks.emplace_back();
+                        chunks.back().reserve(kChunkSize);
+                    }
+                }
+                std::size_t filled = std::min(capacity - (chunk << kChunkShift), kChunkSize);
+                std::vector<Bucket>& storage = chunks[chunk];
+                for (std::size_t i = bucketCount & (kChunkSize - 1); i < std::min(filled, storage.size()); ++i) {
+                    storage[i].state = State::Empty;
+                }
+                if (storage.size() < filled) {
+                    storage.resize(filled);
+                }
+                bucketCount = (chunk << kChunkShift) + filled;
+            }
+        }
+
+        // Moves every full chunk lying wholly below index to pool. The caller guarantees those slots have
+        // been cleared to a default key and value, and must never read them through this table again.
+        void releaseBelow(std::size_t index, ChunkPool& pool) {
+            for (std::size_t chunk = releasedChunks; chunk < (index >> kChunkShift); ++chunk) {
+                if (chunks[chunk].size() == kChunkSize) {
+                    pool.push_back(std::move(chunks[chunk]));
+                }
+                std::vector<Bucket>().swap(chunks[chunk]);
+            }
+            releasedChunks = std::max(releasedChunks, index >> kChunkShift);
+        }
+
+    private:
+        std::vector<std::vector<Bucket>> chunks;
+        std::size_t bucketCount = 0;
+        std::size_t releasedChunks = 0;
+    };
+
+    static constexpr std::size_t kNotFound = static_cast<std::size_t>(-1);
+
+    // Number of old-table slots moved per operation while an incremental resize is in flight. The new
+    // table is twice the old one, so the migration finishes long before inserts can push it past 60%.
+    static constexpr std::size_t kMigrationStep = 8;
+    // Tombstones may occupy at most this fraction of the table before it is compacted in place. Together
+    // with the 60% live-entry ceiling this guarantees every probe chain still ends at an Empty slot.
+    static constexpr double kMaxTombstoneRatio = 0.2;
+    // Number of next-table buckets constructed per put once the load passes 30%. Building 2x capacity
+    // over the 30% of capacity puts left before the threshold needs at least 7 per put.
+    static constexpr std::size_t kPrebuildStep = 16;
+
+    // The tables are mutable because lookups also advance an in-flight migration; this only moves
+    // entries between tables and never changes what get()/contains() observe.
+    mutable BucketTable buckets;
+    // retiring holds the pre-resize table until migrationCursor has walked past its last slot. Slots
+    // below the cursor have all moved out, so probes skip them without reading, and retiringLive counts
+    // the entries still waiting so lookups can ignore the old table once it holds nothing.
+    mutable BucketTable retiring;
+    mutable std::size_t migrationCursor = 0;
+    mutable std::size_t retiringLive = 0;
+    // spare is the next, doubled table, constructed a few buckets at a time ahead of the resize so
+    // beginMigration() does not have to value-initialize millions of buckets in one call.
+    BucketTable spare;
+    // Chunks handed back by the retiring table. The next spare, at least four times as large, reuses
+    // all of them, so the memory stays with the map rather than going back to the allocator.
+    mutable typename BucketTable::ChunkPool chunkPool;
     std::size_t count = 0;
+    // tombstones counts Deleted slots in buckets (not retiring) for the compaction trigger; migrated
+    // entries may land on one, hence mutable like the tables.
+    mutable std::size_t tombstones = 0;
+    mutable ProbeStats probeStats;
+    bool probeCounting = true;
+    ResizePolicy resizePolicy;
+    DeletionPolicy deletionPolicy;
+    Hash hasher;
+    KeyEqual equal;
 
-    std::size_t indexFor(int key) const {
-        // std::hash<int> gives a well-distributed hash; mod by capacity selects a home bucket.
-        return std::hash<int>{}(key) % buckets.size();
+    template <typename K>
+    std::size_t indexFor(const K& key, std::size_t capacity) const {
+        // The hasher spreads keys across the table; mod by capacity selects a home bucket.
+        return hasher(key) % capacity;
     }
 
     double loadFactor() const {
@@ -98,85 +381,1083 @@ private:
 
     void ensureCapacity(std::size_t desired) {
         if (buckets.empty()) {
-            buckets.resize(8);
+            buckets.growTo(8);
             return;
         }
         double projected = static_cast<double>(desired) / static_cast<double>(buckets.size());
         if (projected > 0.6) {
             // Doubling capacity keeps probe sequences short and limits clustering.
-            rehash(buckets.size() * 2);
+            if (resizePolicy == ResizePolicy::Incremental) {
+                finishMigration();
+                beginMigration(buckets.size() * 2);
+            } else {
+                rehash(buckets.size() * 2);
+            }
         }
     }
 
-    void insertInternal(int key, const std::string& value) {
-        std::size_t index = indexFor(key);
+    // Assigning a single argument directly lets a moved-in std::string hand over its buffer, or a copied
+    // one reuse the slot's existing capacity, instead of going through a temporary Value.
+    template <typename Arg>
+    static auto assignValue(Value& slot, Arg&& arg) -> decltype(slot = std::forward<Arg>(arg), void()) {
+        slot = std::forward<Arg>(arg);
+    }
+
+    template <typename... Args>
+    static void assignValue(Value& slot, Args&&... args) {
+        slot = Value(std::forward<Args>(args)...);
+    }
+
+    template <typename K, typename... Args>
+    std::pair<Value*, bool> insertInternal(K&& key, bool overwrite, Args&&... args) {
+        migrateStep();
+        prebuildStep();
+        // Growing before insertion keeps the load factor in the safe range for linear probing.
+        ensureCapacity(count + 1);
+        std::size_t index = indexFor(key, buckets.size());
         std::size_t firstDeleted = buckets.size();
+        DSA_COUNT("hash_map.insert_calls", 1);
         while (true) {
             Bucket& bucket = buckets[index];
+            DSA_COUNT("hash_map.insert_slots", 1);
+            // Counted exactly as findSlot() counts a lookup, terminating Empty slot included, so insert
+            // and lookup probe lengths are comparable and setProbeCounting(false) silences both.
+            if (probeCounting) {
+                ++probeStats.probes;
+            }
             if (bucket.state == State::Empty) {
+                // Keys live in exactly one table, so only a key missing from buckets can still be waiting in
+                // the retiring table; an overwrite of an already-migrated key never looks there.
+                if (Bucket* stale = probeRetiring(key)) {
+                    // The key has not migrated yet; move it over now and treat it as an existing entry.
+                    Bucket& moved = placeMoved(*stale);
+                    --retiringLive;
+                    if (overwrite) {
+                        assignValue(moved.value, std::forward<Args>(args)...);
+                    }
+                    return {&moved.value, false};
+                }
                 // Either claim the empty slot or reuse a previously deleted one for better locality.
                 Bucket* target = &bucket;
                 if (firstDeleted != buckets.size()) {
                     target = &buckets[firstDeleted];
+                    --tombstones;
                 }
-                target->key = key;
-                target->value = value;
+                target->key = std::forward<K>(key);
+                assignValue(target->value, std::forward<Args>(args)...);
                 target->state = State::Occupied;
                 ++count;
-                return;
+                return {&target->value, true};
             }
             if (bucket.state == State::Deleted) {
+                if (probeCounting) {
+                    ++probeStats.tombstoneProbes;
+                }
                 // Remember the first deleted slot so we can recycle it if the key is new.
                 if (firstDeleted == buckets.size()) {
                     firstDeleted = index;
                 }
-            } else if (bucket.key == key) {
+            } else if (equal(bucket.key, key)) {
                 // Existing key: overwrite in place to preserve the probing chain.
-                bucket.value = value;
-                return;
+                if (overwrite) {
+                    assignValue(bucket.value, std::forward<Args>(args)...);
+                }
+                return {&bucket.value, false};
             }
             index = (index + 1) % buckets.size();
         }
     }
 
     void rehash(std::size_t newCapacity) {
-        std::vector<Bucket> oldBuckets = std::move(buckets);
-        buckets = std::vector<Bucket>(newCapacity);
-        count = 0;
-        for (const Bucket& bucket : oldBuckets) {
+        BucketTable oldBuckets = std::move(buckets);
+        buckets = BucketTable(newCapacity);
+        tombstones = 0;
+        for (std::size_t i = 0; i < oldBuckets.size(); ++i) {
+            Bucket& bucket = oldBuckets[i];
             if (bucket.state == State::Occupied) {
-                // Reinserting via insertInternal recomputes the proper home position for the new table size.
-                insertInternal(bucket.key, bucket.value);
+                // Moving recomputes the proper home position for the new table size without copying the payload.
+                placeMoved(bucket);
             }
         }
     }
 
-    const Bucket* findBucket(int key) const {
-        if (buckets.empty()) {
-            return nullptr;
+    void prebuildStep() {
+        if (resizePolicy != ResizePolicy::Incremental || !retiring.empty()) {
+            return;
+        }
+        std::size_t nextCapacity = buckets.size() * 2;
+        if (static_cast<double>(count) < 0.3 * static_cast<double>(buckets.size()) || spare.size() >= nextCapacity) {
+            return;
+        }
+        spare.growTo(std::min(spare.size() + kPrebuildStep, nextCapacity), &chunkPool);
+    }
+
+    void beginMigration(std::size_t newCapacity) {
+        // The current table becomes read-mostly; new inserts land only in the fresh, larger table.
+        retiring = std::move(buckets);
+        if (spare.size() == newCapacity) {
+            buckets = std::move(spare);
+        } else {
+            buckets = BucketTable(newCapacity);
+        }
+        spare = BucketTable();
+        migrationCursor = 0;
+        retiringLive = count;
+        tombstones = 0;
+    }
+
+    void migrateStep() const {
+        if (retiring.empty()) {
+            return;
+        }
+        std::size_t end = std::min(migrationCursor + kMigrationStep, retiring.size());
+        for (; migrationCursor < end; ++migrationCursor) {
+            if (retiring[migrationCursor].state == State::Occupied) {
+                placeMoved(retiring[migrationCursor]);
+                --retiringLive;
+            }
+        }
+        // Hand back each chunk of the old table as soon as the cursor has left it, so no step tears down
+        // more than a chunk and the final step no longer frees the whole table.
+        retiring.releaseBelow(migrationCursor, chunkPool);
+        if (migrationCursor == retiring.size()) {
+            retiring = BucketTable();
+            migrationCursor = 0;
+        }
+    }
+
+    void finishMigration() const {
+        while (!retiring.empty()) {
+            migrateStep();
+        }
+    }
+
+    // Moves an entry from another table into buckets. Keys are unique across tables, so the first free
+    // slot on the new probe path is its home and no key comparisons are needed.
+    Bucket& placeMoved(Bucket& source) const {
+        std::size_t index = indexFor(source.key, buckets.size());
+        while (buckets[index].state == State::Occupied) {
+            index = (index + 1) % buckets.size();
         }
-        std::size_t index = indexFor(key);
-        std::size_t start = index;
+        if (buckets[index].state == State::Deleted) {
+            --tombstones;
+        }
+        buckets[index].key = std::move(source.key);
+        buckets[index].value = std::move(source.value);
+        buckets[index].state = State::Occupied;
+        // Leave a tombstone so keys further along the source's probe chain stay reachable until they move.
+        clearBucket(source, State::Deleted);
+        return buckets[index];
+    }
+
+    static void clearBucket(Bucket& bucket, State state) {
+        // Resetting the payload releases any memory the key or value owned.
+        bucket.key = Key();
+        bucket.value = Value();
+        bucket.state = state;
+    }
+
+    void backwardShiftDelete(std::size_t hole) {
+        // Knuth's Algorithm R: walk the rest of the cluster and pull back every entry whose home position
+        // does not lie cyclically in (hole, next], so each entry stays reachable from its home without tombstones.
+        std::size_t next = hole;
         while (true) {
-            const Bucket& bucket = buckets[index];
+            next = (next + 1) % buckets.size();
+            Bucket& candidate = buckets[next];
+            if (candidate.state != State::Occupied) {
+                // The cluster ends at an Empty slot, so no later entry can depend on the hole.
+                break;
+            }
+            std::size_t home = indexFor(candidate.key, buckets.size());
+            bool homeBetween = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+            if (homeBetween) {
+                continue;
+            }
+            buckets[hole] = std::move(candidate);
+            ++probeStats.shiftedEntries;
+            hole = next;
+        }
+        clearBucket(buckets[hole], State::Empty);
+    }
+
+    void compactIfNeeded() {
+        if (!retiring.empty() ||
+            static_cast<double>(tombstones) <= kMaxTombstoneRatio * static_cast<double>(buckets.size())) {
+            // A table that is still receiving migrated entries is fresh; let the migration finish first.
+            return;
+        }
+        std::size_t tableSize = buckets.size();
+        std::size_t anchor = 0;
+        while (buckets[anchor].state != State::Empty) {
+            ++anchor;
+        }
+        for (std::size_t i = 0; i < tableSize; ++i) {
+            if (buckets[i].state == State::Deleted) {
+                buckets[i].state = State::Empty;
+            }
+        }
+        // Starting just past an Empty slot, every entry's home lies between the anchor and its current slot,
+        // so reinserting entries in cyclic order only ever moves them backwards into already-compacted space.
+        for (std::size_t offset = 1; offset < tableSize; ++offset) {
+            std::size_t index = (anchor + offset) % tableSize;
+            if (buckets[index].state != State::Occupied) {
+                continue;
+            }
+            std::size_t target = indexFor(buckets[index].key, tableSize);
+            while (target != index && buckets[target].state == State::Occupied) {
+                target = (target + 1) % tableSize;
+            }
+            if (target != index) {
+                buckets[target] = std::move(buckets[index]);
+                clearBucket(buckets[index], State::Empty);
+            }
+        }
+        ++probeStats.compactions;
+        probeStats.tombstonesCleared += tombstones;
+        tombstones = 0;
+    }
+
+    // Returns the slot holding key, or kNotFound. Slots below movedBelow are known to be tombstones and
+    // may already be released, so the walk jumps over them instead of reading them.
+    template <typename K>
+    std::size_t findSlot(const BucketTable& table, const K& key, std::size_t movedBelow) const {
+        if (table.empty()) {
+            return kNotFound;
+        }
+        std::size_t index = indexFor(key, table.size());
+        DSA_COUNT("hash_map.probe_calls", 1);
+        for (std::size_t visited = 0; visited < table.size();) {
+            if (index < movedBelow) {
+                visited += movedBelow - index;
+                index = movedBelow % table.size();
+                continue;
+            }
+            const Bucket& bucket = table[index];
+            DSA_COUNT("hash_map.probe_slots", 1);
+            if (probeCounting) {
+                ++probeStats.probes;
+            }
             if (bucket.state == State::Empty) {
                 // An empty slot terminates the search—no later bucket can contain the key.
-                return nullptr;
+                return kNotFound;
             }
-            if (bucket.state == State::Occupied && bucket.key == key) {
-                return &bucket;
+            if (bucket.state == State::Deleted && probeCounting) {
+                ++probeStats.tombstoneProbes;
             }
-            index = (index + 1) % buckets.size();
-            if (index == start) {
-                // We looped through the entire table without success.
+            if (bucket.state == State::Occupied && equal(bucket.key, key)) {
+                return index;
+            }
+            index = (index + 1) % table.size();
+            ++visited;
+        }
+        // We looped through the entire table without success.
+        return kNotFound;
+    }
+
+    template <typename K>
+    Bucket* probe(const K& key) const {
+        std::size_t index = findSlot(buckets, key, 0);
+        return index == kNotFound ? nullptr : &buckets[index];
+    }
+
+    template <typename K>
+    Bucket* probeRetiring(const K& key) const {
+        if (retiringLive == 0) {
+            // Everything left in the old table is a tombstone or empty; nothing can match.
+            return nullptr;
+        }
+        std::size_t index = findSlot(retiring, key, migrationCursor);
+        return index == kNotFound ? nullptr : &retiring[index];
+    }
+
+    template <typename K>
+    Value* findValue(const K& key) const {
+        migrateStep();
+        Bucket* bucket = probe(key);
+        if (!bucket) {
+            // While a migration is in flight the key may still sit in the old table.
+            bucket = probeRetiring(key);
+        }
+        return bucket ? &bucket->value : nullptr;
+    }
+};
+
+// Transparent hasher for std::string keys. Pairing it with std::equal_to<> lets HashMap::find accept
+// std::string_view or string literals directly, so lookups never allocate a temporary std::string.
+struct StringHash {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view text) const {
+        return std::hash<std::string_view>{}(text);
+    }
+};
+
+// The integer-keyed phone-book map used by the demos and benchmarks below.
+using IntStringMap = HashMap<int, std::string>;
+
+// ConcurrentHashMap spreads keys over a fixed, power-of-two number of HashMap shards that each resize
+// on their own. Every shard carries a reader-writer lock: readers of one shard run in parallel, while a
+// writer (including any rehash it triggers) only blocks the keys that hash to that shard.
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class ConcurrentHashMap {
+public:
+    explicit ConcurrentHashMap(std::size_t requestedShards = 64, std::size_t initialCapacityPerShard = 8) {
+        while ((std::size_t(1) << shardBits) < requestedShards) {
+            ++shardBits;
+        }
+        shardCount = std::size_t(1) << shardBits;
+        shards.reset(new Shard[shardCount]);
+        for (std::size_t i = 0; i < shardCount; ++i) {
+            shards[i].map = ShardMap(initialCapacityPerShard);
+            // Shared-locked readers must not write anything, including the probe counters.
+            shards[i].map.setProbeCounting(false);
+        }
+    }
+
+    template <typename V>
+    void put(const Key& key, V&& value) {
+        Shard& shard = shardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.map.put(key, std::forward<V>(value));
+    }
+
+    // get copies the value out while the shard lock is held; handing out a pointer would let it dangle
+    // as soon as another thread rehashes the shard.
+    bool get(const Key& key, Value& value) const {
+        const Shard& shard = shardFor(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.map.get(key, value);
+    }
+
+    bool contains(const Key& key) const {
+        const Shard& shard = shardFor(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.map.contains(key);
+    }
+
+    bool remove(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.map.remove(key);
+    }
+
+    // size visits the shards one at a time, so under concurrent writes it is a snapshot, not a barrier.
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < shardCount; ++i) {
+            std::shared_lock<std::shared_mutex> lock(shards[i].mutex);
+            total += shards[i].map.size();
+        }
+        return total;
+    }
+
+private:
+    using ShardMap = HashMap<Key, Value, Hash, KeyEqual>;
+
+    // Each shard sits on its own cache line so locking one never invalidates a neighbour's lock word.
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        ShardMap map;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    std::size_t shardCount = 1;
+    unsigned shardBits = 0;
+    Hash hasher;
+
+    std::size_t shardIndex(const Key& key) const {
+        if (shardBits == 0) {
+            return 0;
+        }
+        // The shard comes from the top bits of a multiplicative mix. Taking low bits instead would leave
+        // every key in a shard sharing the low bits that HashMap itself uses to pick a home bucket.
+        std::uint64_t mixed = static_cast<std::uint64_t>(hasher(key)) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<std::size_t>(mixed >> (64 - shardBits));
+    }
+
+    Shard& shardFor(const Key& key) {
+        return shards[shardIndex(key)];
+    }
+
+    const Shard& shardFor(const Key& key) const {
+        return shards[shardIndex(key)];
+    }
+};
+
+// GroupProbingHashMap offers the same interface as HashMap but uses a Swiss-table style layout.
+// Each slot owns a one-byte control tag kept in a dense array apart from the keys and values, so a
+// probe scans 16 tags (one SIMD register) per step and only touches a key when the 7-bit hash
+// fragment stored in its tag already matches. Tags reuse HashMap's Empty/Deleted/Occupied meaning:
+// negative tags are Empty or Deleted, and any non-negative tag marks an Occupied slot.
+class GroupProbingHashMap {
+public:
+    explicit GroupProbingHashMap(std::size_t initialCapacity = kGroupWidth) {
+        std::size_t capacity = kGroupWidth;
+        // Capacity stays a power-of-two multiple of the group width so groups can be selected by masking.
+        while (capacity < initialCapacity) {
+            capacity *= 2;
+        }
+        allocate(capacity);
+    }
+
+    void put(int key, const std::string& value) {
+        std::size_t hash = hashFor(key);
+        std::size_t slot = findSlot(key, hash);
+        if (slot != kNotFound) {
+            // Existing key: overwrite in place, mirroring HashMap::insertInternal.
+            values[slot] = value;
+            return;
+        }
+        ensureCapacity(count + 1);
+        slot = findInsertSlot(hash);
+        if (control[slot] == kDeleted) {
+            --deleted;
+        }
+        control[slot] = fragmentFor(hash);
+        keys[slot] = key;
+        values[slot] = value;
+        ++count;
+    }
+
+    bool get(int key, std::string& value) const {
+        std::size_t slot = findSlot(key, hashFor(key));
+        if (slot == kNotFound) {
+            return false;
+        }
+        value = values[slot];
+        return true;
+    }
+
+    bool contains(int key) const {
+        return findSlot(key, hashFor(key)) != kNotFound;
+    }
+
+    bool remove(int key) {
+        std::size_t slot = findSlot(key, hashFor(key));
+        if (slot == kNotFound) {
+            return false;
+        }
+        // A probe stops at the first group holding an Empty tag, so if this slot's group already has one
+        // no chain ever continued past it and the slot can go straight back to Empty instead of a tombstone.
+        ControlGroup group(&control[slot & ~(kGroupWidth - 1)]);
+        if (group.matchEmpty() != 0) {
+            control[slot] = kEmpty;
+        } else {
+            control[slot] = kDeleted;
+            ++deleted;
+        }
+        values[slot].clear();
+        --count;
+        return true;
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+private:
+    static constexpr std::size_t kGroupWidth = 16;
+    static constexpr std::size_t kNotFound = static_cast<std::size_t>(-1);
+    // Control tags: Empty and Deleted are negative so a single sign test finds every free slot.
+    static constexpr std::int8_t kEmpty = -128;
+    static constexpr std::int8_t kDeleted = -2;
+
+    // ControlGroup loads 16 consecutive tags and reports matching lanes as a 16-bit mask.
+    class ControlGroup {
+    public:
+        explicit ControlGroup(const std::int8_t* tags) {
+#if defined(HASH_MAP_USE_SSE2)
+            lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags));
+#elif defined(HASH_MAP_USE_NEON)
+            lanes = vld1q_s8(tags);
+#else
+            for (std::size_t i = 0; i < kGroupWidth; ++i) {
+                lanes[i] = tags[i];
+            }
+#endif
+        }
+
+        std::uint32_t match(std::int8_t tag) const {
+#if defined(HASH_MAP_USE_SSE2)
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lanes, _mm_set1_epi8(tag))));
+#elif defined(HASH_MAP_USE_NEON)
+            return movemask(vceqq_s8(lanes, vdupq_n_s8(tag)));
+#else
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < kGroupWidth; ++i) {
+                mask |= static_cast<std::uint32_t>(lanes[i] == tag) << i;
+            }
+            return mask;
+#endif
+        }
+
+        std::uint32_t matchEmpty() const {
+            return match(kEmpty);
+        }
+
+        std::uint32_t matchEmptyOrDeleted() const {
+#if defined(HASH_MAP_USE_SSE2)
+            // movemask collects the sign bits directly, and only Empty/Deleted tags are negative.
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(lanes));
+#elif defined(HASH_MAP_USE_NEON)
+            return movemask(vcltq_s8(lanes, vdupq_n_s8(0)));
+#else
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < kGroupWidth; ++i) {
+                mask |= static_cast<std::uint32_t>(lanes[i] < 0) << i;
+            }
+            return mask;
+#endif
+        }
+
+    private:
+#if defined(HASH_MAP_USE_SSE2)
+        __m128i lanes;
+#elif defined(HASH_MAP_USE_NEON)
+        int8x16_t lanes;
+
+        static std::uint32_t movemask(uint8x16_t comparison) {
+            // NEON has no movemask, so weight each lane by its bit position and sum each half.
+            static const std::uint8_t kLaneBits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+            uint8x16_t weighted = vandq_u8(comparison, vld1q_u8(kLaneBits));
+            std::uint32_t low = vaddv_u8(vget_low_u8(weighted));
+            std::uint32_t high = vaddv_u8(vget_high_u8(weighted));
+            return low | (high << 8);
+        }
+#else
+        std::int8_t lanes[kGroupWidth];
+#endif
+    };
+
+    // control, keys, and values are parallel arrays indexed by slot number.
+    std::vector<std::int8_t> control;
+    std::vector<int> keys;
+    std::vector<std::string> values;
+    std::size_t count = 0;
+    std::size_t deleted = 0;
+
+    static std::size_t hashFor(int key) {
+        // std::hash<int> is often the identity, so mix it to spread entropy into both the group index
+        // (high bits) and the 7-bit tag fragment (low bits).
+        std::uint64_t hash = static_cast<std::uint64_t>(std::hash<int>{}(key));
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return static_cast<std::size_t>(hash);
+    }
+
+    static std::int8_t fragmentFor(std::size_t hash) {
+        return static_cast<std::int8_t>(hash & 0x7F);
+    }
+
+    static std::size_t lowestLane(std::uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<std::size_t>(__builtin_ctz(mask));
+#else
+        std::size_t lane = 0;
+        while ((mask & 1U) == 0) {
+            mask >>= 1;
+            ++lane;
+        }
+        return lane;
+#endif
+    }
+
+    std::size_t groupMask() const {
+        return control.size() / kGroupWidth - 1;
+    }
+
+    void allocate(std::size_t capacity) {
+        control.assign(capacity, kEmpty);
+        keys.assign(capacity, 0);
+        values.assign(capacity, std::string());
+        count = 0;
+        deleted = 0;
+    }
+
+    std::size_t findSlot(int key, std::size_t hash) const {
+        std::int8_t fragment = fragmentFor(hash);
+        std::size_t group = (hash >> 7) & groupMask();
+        DSA_COUNT("group_map.find_calls", 1);
+        // Triangular steps over a power-of-two group count visit every group exactly once.
+        for (std::size_t step = 1;; ++step) {
+            DSA_COUNT("group_map.find_groups", 1);
+            std::size_t base = group * kGroupWidth;
+            ControlGroup tags(&control[base]);
+            for (std::uint32_t mask = tags.match(fragment); mask != 0; mask &= mask - 1) {
+                // Only lanes whose fragment matches pay for a key comparison.
+                std::size_t slot = base + lowestLane(mask);
+                if (keys[slot] == key) {
+                    return slot;
+                }
+            }
+            if (tags.matchEmpty() != 0) {
+                // An Empty tag ends the chain just like an Empty bucket does in HashMap::probe.
+                return kNotFound;
+            }
+            group = (group + step) & groupMask();
+        }
+    }
+
+    std::size_t findInsertSlot(std::size_t hash) const {
+        std::size_t group = (hash >> 7) & groupMask();
+        for (std::size_t step = 1;; ++step) {
+            std::size_t base = group * kGroupWidth;
+            std::uint32_t mask = ControlGroup(&control[base]).matchEmptyOrDeleted();
+            if (mask != 0) {
+                // The first free lane on the probe path is reused, tombstones included.
+                return base + lowestLane(mask);
+            }
+            group = (group + step) & groupMask();
+        }
+    }
+
+    void ensureCapacity(std::size_t desired) {
+        double capacity = static_cast<double>(control.size());
+        if (static_cast<double>(desired) / capacity > 0.6) {
+            // Same 60% ceiling as HashMap, so both layouts are compared at identical load factors.
+            rehash(control.size() * 2);
+        } else if (static_cast<double>(desired + deleted) / capacity > 0.6) {
+            // Tombstones lengthen probes without holding data; rebuild in place to clear them out.
+            rehash(control.size());
+        }
+    }
+
+    void rehash(std::size_t newCapacity) {
+        std::vector<std::int8_t> oldControl = std::move(control);
+        std::vector<int> oldKeys = std::move(keys);
+        std::vector<std::string> oldValues = std::move(values);
+        allocate(newCapacity);
+        for (std::size_t i = 0; i < oldControl.size(); ++i) {
+            if (oldControl[i] >= 0) {
+                // Keys are unique already, so reinsertion only needs a free slot, never a key comparison.
+                std::size_t hash = hashFor(oldKeys[i]);
+                std::size_t slot = findInsertSlot(hash);
+                control[slot] = fragmentFor(hash);
+                keys[slot] = oldKeys[i];
+                values[slot] = std::move(oldValues[i]);
+                ++count;
+            }
+        }
+    }
+};
+
+#if defined(DSA_HAVE_MMAP)
+// Snapshot file layout, in host byte order:
+//   SnapshotHeader | SnapshotSlot[slotCount] | string area
+// Slots form a linear-probing table of their own, so a reader probes the mapped pages exactly the way
+// HashMap probes its buckets. Each occupied slot points at its value's bytes in the string area by
+// offset, which keeps the slot fixed-size and the file position-independent.
+struct SnapshotHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t slotSize;
+    std::uint64_t slotCount;
+    std::uint64_t entryCount;
+    std::uint64_t stringAreaOffset;
+    std::uint64_t stringAreaSize;
+};
+
+struct SnapshotSlot {
+    std::int32_t key;
+    std::uint32_t valueLength;
+    // Offset into the string area; kEmptySnapshotSlot marks a free slot.
+    std::uint64_t valueOffset;
+};
+
+constexpr char kSnapshotMagic[8] = {'H', 'M', 'S', 'N', 'A', 'P', '\0', '\0'};
+constexpr std::uint32_t kSnapshotVersion = 1;
+constexpr std::uint64_t kEmptySnapshotSlot = ~std::uint64_t(0);
+
+// Snapshots use their own fixed hash rather than std::hash, whose output may differ between standard
+// libraries, so a file written by one build stays readable by another.
+inline std::uint64_t snapshotHash(std::int32_t key) {
+    std::uint64_t hash = static_cast<std::uint32_t>(key);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Writes every live entry of an int -> string map into a snapshot file. The slot table is sized for the
+// same 60% load factor HashMap uses, and values are packed back to back in the string area.
+template <typename Hash, typename KeyEqual>
+void writeSnapshot(const HashMap<int, std::string, Hash, KeyEqual>& map, const std::string& path) {
+    std::uint64_t slotCount = 8;
+    while (static_cast<double>(map.size()) > 0.6 * static_cast<double>(slotCount)) {
+        slotCount *= 2;
+    }
+    std::vector<SnapshotSlot> slots(slotCount, SnapshotSlot{0, 0, kEmptySnapshotSlot});
+    std::string strings;
+    map.forEach([&](int key, const std::string& value) {
+        if (value.size() > UINT32_MAX) {
+            throw std::length_error("Snapshot values are limited to 4 GiB each");
+        }
+        std::uint64_t index = snapshotHash(key) & (slotCount - 1);
+        while (slots[index].valueOffset != kEmptySnapshotSlot) {
+            index = (index + 1) & (slotCount - 1);
+        }
+        slots[index] = SnapshotSlot{key, static_cast<std::uint32_t>(value.size()), strings.size()};
+        strings += value;
+    });
+
+    SnapshotHeader header{};
+    std::copy(std::begin(kSnapshotMagic), std::end(kSnapshotMagic), header.magic);
+    header.version = kSnapshotVersion;
+    header.slotSize = sizeof(SnapshotSlot);
+    header.slotCount = slotCount;
+    header.entryCount = map.size();
+    header.stringAreaOffset = sizeof(SnapshotHeader) + slotCount * sizeof(SnapshotSlot);
+    header.stringAreaSize = strings.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot open snapshot for writing: " + path);
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(slots.data()),
+              static_cast<std::streamsize>(slots.size() * sizeof(SnapshotSlot)));
+    out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+    if (!out) {
+        throw std::runtime_error("Failed writing snapshot: " + path);
+    }
+}
+
+// MappedSnapshot opens a snapshot read-only with mmap and answers lookups straight from the mapped
+// pages: nothing is deserialized, so opening costs one system call and pages fault in on first touch.
+class MappedSnapshot {
+public:
+    // Lookups probe scattered slots, so the mapping is not marked sequential.
+    explicit MappedSnapshot(const std::string& path) : file(path, "snapshot", MappedFile::Access::Random) {
+        if (file.size() < sizeof(SnapshotHeader)) {
+            throw std::runtime_error("Snapshot is truncated: " + path);
+        }
+        validate(path);
+    }
+
+    // Zero-copy lookup: the view points into the mapping and stays valid for this object's lifetime.
+    bool get(int key, std::string_view& value) const {
+        const SnapshotSlot* slot = findSlot(key);
+        if (!slot) {
+            return false;
+        }
+        value = std::string_view(strings + slot->valueOffset, slot->valueLength);
+        return true;
+    }
+
+    bool get(int key, std::string& value) const {
+        std::string_view view;
+        if (!get(key, view)) {
+            return false;
+        }
+        value.assign(view.data(), view.size());
+        return true;
+    }
+
+    bool contains(int key) const {
+        return findSlot(key) != nullptr;
+    }
+
+    std::size_t size() const {
+        return static_cast<std::size_t>(header->entryCount);
+    }
+
+private:
+    MappedFile file;
+    const SnapshotHeader* header = nullptr;
+    const SnapshotSlot* slots = nullptr;
+    const char* strings = nullptr;
+
+    // Checks the header against the file size before any slot is read. Every size is compared by
+    // division or subtraction against what the file actually holds, so a corrupt count cannot overflow
+    // into a small, plausible-looking offset.
+    void validate(const std::string& path) {
+        const char* base = file.data();
+        std::size_t length = file.size();
+        header = reinterpret_cast<const SnapshotHeader*>(base);
+        std::uint64_t slotBytesAvailable = length - sizeof(SnapshotHeader);
+        bool valid = std::equal(std::begin(kSnapshotMagic), std::end(kSnapshotMagic), header->magic) &&
+                     header->version == kSnapshotVersion && header->slotSize == sizeof(SnapshotSlot) &&
+                     header->slotCount != 0 && (header->slotCount & (header->slotCount - 1)) == 0 &&
+                     header->entryCount < header->slotCount &&
+                     header->slotCount <= slotBytesAvailable / sizeof(SnapshotSlot);
+        if (valid) {
+            std::uint64_t stringAreaOffset = sizeof(SnapshotHeader) + header->slotCount * sizeof(SnapshotSlot);
+            valid = header->stringAreaOffset == stringAreaOffset &&
+                    header->stringAreaSize <= length - stringAreaOffset;
+        }
+        if (!valid) {
+            throw std::runtime_error("Not a valid snapshot: " + path);
+        }
+        slots = reinterpret_cast<const SnapshotSlot*>(base + sizeof(SnapshotHeader));
+        strings = base + header->stringAreaOffset;
+    }
+
+    // Slots are checked as lookups reach them rather than all at open, which would fault in the whole
+    // slot table and give up the O(1) open. A slot whose value lies outside the string area throws.
+    const SnapshotSlot* findSlot(int key) const {
+        std::uint64_t mask = header->slotCount - 1;
+        std::uint64_t index = snapshotHash(key) & mask;
+        // The writer keeps the slot table under 60% full, so every probe chain ends at an empty slot. A
+        // corrupt file may have no empty slot at all, hence the bound of one pass over the table.
+        for (std::uint64_t probes = 0; probes < header->slotCount; ++probes) {
+            const SnapshotSlot& slot = slots[index];
+            if (slot.valueOffset == kEmptySnapshotSlot) {
                 return nullptr;
             }
+            if (slot.key == key) {
+                if (slot.valueOffset > header->stringAreaSize ||
+                    slot.valueLength > header->stringAreaSize - slot.valueOffset) {
+                    throw std::runtime_error("Snapshot slot points outside its string area");
+                }
+                return &slot;
+            }
+            index = (index + 1) & mask;
         }
+        return nullptr;
+    }
+};
+#endif
+
+// Compares HashMap's bucket-at-a-time probing with GroupProbingHashMap's 16-wide tag scans. Both tables
+// are presized and filled to exactly a 0.6 load factor so neither resizes while lookups are timed.
+template <typename Map>
+void benchmarkLookups(const char* label, const std::vector<int>& present, const std::vector<int>& absent,
+                      std::size_t capacity) {
+    Map map(capacity);
+    for (int key : present) {
+        map.put(key, "v" + std::to_string(key % 1000));
+    }
+
+    std::string value;
+    std::size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int key : present) {
+        found += map.get(key, value) ? 1 : 0;
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int key : absent) {
+        found += map.contains(key) ? 1 : 0;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double hitNs = std::chrono::duration<double, std::nano>(middle - start).count() / present.size();
+    double missNs = std::chrono::duration<double, std::nano>(end - middle).count() / absent.size();
+    std::cout << label << ": " << hitNs << " ns/hit, " << missNs << " ns/miss (found " << found << ")\n";
+    bench::record(std::string(label) + " ns/hit", hitNs);
+    bench::record(std::string(label) + " ns/miss", missNs);
+}
+
+void runLookupBenchmark() {
+    const std::size_t capacity = std::size_t(1) << 20;
+    const std::size_t entries = static_cast<std::size_t>(capacity * 0.6);
+    // Hits are drawn from non-negative keys and misses from negative ones, so misses never collide.
+    std::vector<int> present = bench::makeKeys(bench::Distribution::Uniform, entries, 42);
+    std::vector<int> absent = bench::makeKeys(bench::Distribution::Uniform, entries, 43);
+    for (int& key : absent) {
+        key = -1 - key;
+    }
+    std::cout << "Lookup benchmark: " << entries << " keys in " << capacity << " slots (load 0.6)\n";
+    benchmarkLookups<IntStringMap>("HashMap (linear probing)", present, absent, capacity);
+    benchmarkLookups<GroupProbingHashMap>("GroupProbingHashMap (16-wide tags)", present, absent, capacity);
+}
+
+// Times every individual put() while a table grows from its default size, so the resize spikes show
+// up in the tail percentiles rather than being averaged away.
+void benchmarkPutLatency(const char* label, IntStringMap::ResizePolicy policy, const std::vector<int>& keys) {
+    IntStringMap map(8, policy);
+    std::vector<double> latencies;
+    latencies.reserve(keys.size());
+    for (int key : keys) {
+        auto start = std::chrono::steady_clock::now();
+        map.put(key, "value-" + std::to_string(key % 1000));
+        auto end = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double fraction) {
+        return latencies[static_cast<std::size_t>(fraction * (latencies.size() - 1))];
+    };
+    std::cout << label << ": p50 " << percentile(0.5) << " ns, p99.9 " << percentile(0.999) << " ns, p99.99 "
+              << percentile(0.9999) << " ns, max "
+              << latencies.back() << " ns\n";
+    bench::record(std::string(label) + " p50 ns", percentile(0.5));
+    bench::record(std::string(label) + " p99.9 ns", percentile(0.999));
+    bench::record(std::string(label) + " p99.99 ns", percentile(0.9999));
+    bench::record(std::string(label) + " max ns", latencies.back());
+}
+
+void runPutLatencyBenchmark() {
+    std::vector<int> keys = bench::makeKeys(bench::Distribution::Uniform, 1 << 20, 7);
+    std::cout << "Put latency benchmark: " << keys.size() << " inserts starting from 8 buckets\n";
+    benchmarkPutLatency("AllAtOnce rehash", IntStringMap::ResizePolicy::AllAtOnce, keys);
+    benchmarkPutLatency("Incremental rehash", IntStringMap::ResizePolicy::Incremental, keys);
+}
+
+// Runs an insert/delete churn at a steady 50% load, then measures misses, which scan whole clusters.
+// The counters show how many probe steps went to tombstones and what each deletion policy did instead.
+void benchmarkChurn(const char* label, IntStringMap::DeletionPolicy deletion) {
+    const std::size_t capacity = std::size_t(1) << 18;
+    IntStringMap map(capacity, IntStringMap::ResizePolicy::AllAtOnce, deletion);
+    bench::Rng rng(11);
+    std::vector<int> live(capacity / 2);
+    for (int& key : live) {
+        // Random keys matter here: std::hash<int> is the identity, so sequential keys would form one cluster.
+        key = rng.between(0, 1 << 30);
+        map.put(key, "x");
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < capacity * 4; ++round) {
+        // Replace a random live key with a fresh one, so the live count never changes but slots keep churning.
+        std::size_t victim = rng.below(live.size());
+        map.remove(live[victim]);
+        live[victim] = rng.between(0, 1 << 30);
+        map.put(live[victim], "x");
+    }
+    auto middle = std::chrono::steady_clock::now();
+    IntStringMap::ProbeStats before = map.stats();
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < live.size(); ++i) {
+        found += map.contains(-1 - static_cast<int>(i)) ? 1 : 0;
+    }
+    auto end = std::chrono::steady_clock::now();
+    const IntStringMap::ProbeStats& after = map.stats();
+
+    double churnNs = std::chrono::duration<double, std::nano>(middle - start).count() / (capacity * 4);
+    double missNs = std::chrono::duration<double, std::nano>(end - middle).count() / live.size();
+    double probesPerMiss = static_cast<double>(after.probes - before.probes) / live.size();
+    double tombstonesPerMiss = static_cast<double>(after.tombstoneProbes - before.tombstoneProbes) / live.size();
+    std::cout << label << ": " << churnNs << " ns/churn op, " << missNs << " ns/miss, " << probesPerMiss
+              << " probes/miss (" << tombstonesPerMiss << " on tombstones), " << after.tombstoneProbes
+              << " tombstone probes total, " << after.compactions << " compactions clearing "
+              << after.tombstonesCleared << " tombstones, " << after.shiftedEntries << " shifted entries"
+              << (found == 0 ? "" : " (unexpected hit)") << "\n";
+    bench::record(std::string(label) + " ns/churn op", churnNs);
+    bench::record(std::string(label) + " ns/miss", missNs);
+    bench::record(std::string(label) + " probes/miss", probesPerMiss);
+}
+
+void runChurnBenchmark() {
+    std::cout << "Churn benchmark: remove+insert at 50% load\n";
+    benchmarkChurn("Tombstone + compaction", IntStringMap::DeletionPolicy::Tombstone);
+    benchmarkChurn("Backward-shift deletion", IntStringMap::DeletionPolicy::BackwardShift);
+}
+
+// Baseline for the concurrency benchmark: one IntStringMap behind one mutex.
+class GlobalLockHashMap {
+public:
+    void put(int key, const std::string& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        map.put(key, value);
     }
+
+    bool get(int key, std::string& value) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return map.get(key, value);
+    }
+
+private:
+    mutable std::mutex mutex;
+    IntStringMap map;
 };
 
-int main() {
-    HashMap phoneBook;
+// Runs threads that each issue a fixed number of random gets and puts, writePercent of them puts, and
+// returns the aggregate throughput in millions of operations per second.
+template <typename Map>
+double measureThroughput(Map& map, unsigned threadCount, unsigned writePercent, std::size_t opsPerThread,
+                         int keySpace) {
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> hits{0};
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&map, &hits, t, writePercent, opsPerThread, keySpace]() {
+            bench::Rng rng(1000 + t);
+            std::string value;
+            std::size_t localHits = 0;
+            for (std::size_t op = 0; op < opsPerThread; ++op) {
+                int key = static_cast<int>(rng.below(static_cast<std::uint64_t>(keySpace)));
+                if (rng.below(100) < writePercent) {
+                    map.put(key, "w");
+                } else {
+                    localHits += map.get(key, value) ? 1 : 0;
+                }
+            }
+            hits += localHits;
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(threadCount * opsPerThread) / seconds / 1e6;
+}
+
+void runConcurrencyBenchmark() {
+    const int keySpace = 1 << 18;
+    const std::size_t opsPerThread = 200000;
+    std::cout << "Concurrency benchmark (Mops/s, " << std::thread::hardware_concurrency()
+              << " hardware threads): global lock vs 64 shards\n";
+    for (unsigned writePercent : {0U, 10U, 50U}) {
+        for (unsigned threads : {1U, 2U, 4U, 8U}) {
+            // Both maps start half full so reads see a realistic mix of hits and misses.
+            GlobalLockHashMap globalMap;
+            ConcurrentHashMap<int, std::string> shardedMap(64);
+            for (int key = 0; key < keySpace; key += 2) {
+                globalMap.put(key, "seed");
+                shardedMap.put(key, "seed");
+            }
+            double global = measureThroughput(globalMap, threads, writePercent, opsPerThread, keySpace);
+            double sharded = measureThroughput(shardedMap, threads, writePercent, opsPerThread, keySpace);
+            std::cout << "  " << writePercent << "% writes, " << threads << " threads: global " << global
+                      << ", sharded " << sharded << "\n";
+            std::string config = std::to_string(writePercent) + "% writes " + std::to_string(threads) + " threads";
+            bench::record("global lock " + config + " Mops/s", global);
+            bench::record("64 shards " + config + " Mops/s", sharded);
+        }
+    }
+}
+
+#if defined(DSA_HAVE_MMAP)
+// Contrasts rebuilding a table with millions of put() calls against opening a snapshot of it.
+void runSnapshotBenchmark() {
+    const int entries = 1 << 21;
+    const std::string path = "hash_map_bench.snapshot";
+    auto start = std::chrono::steady_clock::now();
+    IntStringMap map;
+    for (int key = 0; key < entries; ++key) {
+        map.put(key, "contact-" + std::to_string(key));
+    }
+    auto built = std::chrono::steady_clock::now();
+    writeSnapshot(map, path);
+    auto written = std::chrono::steady_clock::now();
+    MappedSnapshot snapshot(path);
+    auto opened = std::chrono::steady_clock::now();
+    std::size_t found = 0;
+    std::string_view value;
+    for (int key = 0; key < entries; ++key) {
+        found += snapshot.get(key, value) ? 1 : 0;
+    }
+    auto probed = std::chrono::steady_clock::now();
+    std::remove(path.c_str());
+
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::cout << "Snapshot benchmark: " << entries << " entries\n"
+              << "  rebuild with put(): " << ms(start, built) << " ms\n"
+              << "  write snapshot: " << ms(built, written) << " ms\n"
+              << "  open mapped snapshot: " << ms(written, opened) << " ms\n"
+              << "  look up every key from the mapping: " << ms(opened, probed) << " ms (found " << found << ")\n";
+    bench::record("rebuild with put ns/entry", ms(start, built) * 1e6 / entries);
+    bench::record("write snapshot ns/entry", ms(built, written) * 1e6 / entries);
+    bench::record("open mapped snapshot ms", ms(written, opened));
+    bench::record("mapped lookup ns/op", ms(opened, probed) * 1e6 / entries);
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    IntStringMap phoneBook;
 
     phoneBook.put(5551234, "Alice");
     phoneBook.put(5552345, "Bob");
@@ -204,5 +1485,87 @@ int main() {
         }
     }
 
+    GroupProbingHashMap groupedBook;
+    groupedBook.put(5551234, "Alice");
+    groupedBook.put(5552345, "Bob");
+    groupedBook.remove(5551234);
+    // The grouped layout answers the same queries; only the memory layout behind them changes.
+    std::cout << "Grouped map contains 5551234? " << (groupedBook.contains(5551234) ? "yes" : "no")
+              << ", 5552345? " << (groupedBook.contains(5552345) ? "yes" : "no") << "\n";
+
+    IntStringMap incrementalBook(8, IntStringMap::ResizePolicy::Incremental);
+    for (int key = 0; key < 10; ++key) {
+        incrementalBook.put(5550000 + key, "Contact " + std::to_string(key));
+    }
+    // The last put crossed the 60% threshold, so part of the old table is still waiting to migrate.
+    std::cout << "Incremental map still migrating? " << (incrementalBook.migrating() ? "yes" : "no")
+              << ", 5550003 -> " << (incrementalBook.get(5550003, contact) ? contact : "missing") << "\n";
+    // Moving takes both tables mid-migration; the moved-from map is left empty and safe to reuse.
+    IntStringMap movedBook = std::move(incrementalBook);
+    incrementalBook.put(2, "Reused");
+    std::cout << "Moved map 5550009 -> " << (movedBook.get(5550009, contact) ? contact : "missing")
+              << ", moved-from map 2 -> " << (incrementalBook.get(2, contact) ? contact : "missing") << "\n";
+
+    IntStringMap shiftingBook(8, IntStringMap::ResizePolicy::AllAtOnce,
+                              IntStringMap::DeletionPolicy::BackwardShift);
+    for (int key : {8, 16, 24}) {
+        // All three keys share home bucket 0, so removing the first pulls the other two back one slot each.
+        shiftingBook.put(key, "Shared home " + std::to_string(key));
+    }
+    shiftingBook.remove(8);
+    std::cout << "Backward-shift map shifted " << shiftingBook.stats().shiftedEntries << " entries, 24 -> "
+              << (shiftingBook.get(24, contact) ? contact : "missing") << "\n";
+
+    HashMap<std::string, int, StringHash, std::equal_to<>> wordCounts;
+    for (const char* word : {"apple", "banana", "apple", "cherry", "apple"}) {
+        // tryEmplace only constructs the counter the first time a word is seen.
+        ++*wordCounts.tryEmplace(word, 0).first;
+    }
+    std::string_view query = "apple";
+    // The transparent hasher lets a string_view probe the table without building a std::string.
+    const int* appleCount = wordCounts.find(query);
+    std::cout << "Word count for " << query << ": " << (appleCount ? *appleCount : 0) << " across "
+              << wordCounts.size() << " distinct words\n";
+
+    ConcurrentHashMap<int, std::string> sharedBook(8);
+    std::vector<std::thread> writers;
+    for (int writer = 0; writer < 4; ++writer) {
+        // Four threads insert disjoint key ranges; keys that land in different shards never contend.
+        writers.emplace_back([&sharedBook, writer]() {
+            for (int i = 0; i < 100; ++i) {
+                sharedBook.put(writer * 1000 + i, "Thread " + std::to_string(writer));
+            }
+        });
+    }
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    std::cout << "Concurrent map holds " << sharedBook.size() << " entries, 2042 -> "
+              << (sharedBook.get(2042, contact) ? contact : "missing") << "\n";
+
+#if defined(DSA_HAVE_MMAP)
+    // Persist the phone book and serve lookups straight from the mapped file, as a warm restart would.
+    writeSnapshot(phoneBook, "phone_book.snapshot");
+    {
+        MappedSnapshot snapshot("phone_book.snapshot");
+        std::string_view mapped;
+        std::cout << "Snapshot holds " << snapshot.size() << " entries, 5553456 -> "
+                  << (snapshot.get(5553456, mapped) ? mapped : std::string_view("missing")) << "\n";
+    }
+    std::remove("phone_book.snapshot");
+#endif
+
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("hash_map", argc, argv);
+        suite.run("lookup", runLookupBenchmark);
+        suite.run("put_latency", runPutLatencyBenchmark);
+        suite.run("churn", runChurnBenchmark);
+        suite.run("concurrency", runConcurrencyBenchmark);
+#if defined(DSA_HAVE_MMAP)
+        suite.run("snapshot", runSnapshotBenchmark);
+#endif
+        return suite.finish();
+    }
+
     return 0;
 }
@@ -1,5 +1,10 @@
+#include <chrono>
 #include <cstddef>
 #include <iostream>
+#include <string>
+#include <vector>
+
+#include "bench_harness.h"
 
 // This program implements a singly linked list that stores integers while supporting
 // fast insertions at both the head and tail, targeted insertion after a value, and
@@ -15,6 +20,7 @@ public:
     void pushFront(int value) {
         // Prepend by wiring the new node to the existing head and updating head pointer.
         Node* node = new Node(value);
+        DSA_COUNT("linked_list.node_allocations", 1);
         node->next = head;
         head = node;
         if (!tail) {
@@ -26,6 +32,7 @@ public:
 
     void pushBack(int value) {
         Node* node = new Node(value);
+        DSA_COUNT("linked_list.node_allocations", 1);
         if (!head) {
             head = tail = node;
         } else {
@@ -46,6 +53,7 @@ public:
             return false;
         }
         Node* node = new Node(value);
+        DSA_COUNT("linked_list.node_allocations", 1);
         node->next = current->next;
         current->next = node;
         if (current == tail) {
@@ -61,6 +69,7 @@ public:
         Node* current = head;
         // Find the first node matching the requested value while retaining the predecessor pointer.
         while (current && current->value != value) {
+            DSA_COUNT("linked_list.remove_steps", 1);
             previous = current;
             current = current->next;
         }
@@ -78,6 +87,7 @@ public:
             tail = previous;
         }
         delete current;
+        DSA_COUNT("linked_list.node_frees", 1);
         --length;
         if (length == 0) {
             // Keep tail consistent when the list becomes empty.
@@ -112,6 +122,7 @@ public:
             Node* next = current->next;
             // Delete nodes in sequence to release memory allocated via new.
             delete current;
+            DSA_COUNT("linked_list.node_frees", 1);
             current = next;
         }
         head = nullptr;
@@ -145,7 +156,56 @@ private:
     std::size_t length = 0;
 };
 
-int main() {
+// Appends and prepends a few million keys, then removes a Zipf-skewed sample by value from a shorter
+// list. All keys come from the shared harness, so runs are comparable between releases.
+void runListBenchmark() {
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::vector<int> keys = bench::makeKeys(bench::Distribution::Uniform, 1 << 22);
+    auto start = std::chrono::steady_clock::now();
+    {
+        SinglyLinkedList list;
+        for (int key : keys) {
+            list.pushBack(key);
+        }
+        auto filled = std::chrono::steady_clock::now();
+        std::cout << "List benchmark: pushBack " << keys.size() << " keys " << ms(start, filled) << " ms\n";
+        bench::record("pushBack ns/op", std::chrono::duration<double, std::nano>(filled - start).count() / keys.size());
+    }
+    start = std::chrono::steady_clock::now();
+    {
+        SinglyLinkedList list;
+        for (int key : keys) {
+            list.pushFront(key);
+        }
+        auto filled = std::chrono::steady_clock::now();
+        std::cout << "  pushFront " << keys.size() << " keys " << ms(start, filled) << " ms\n";
+        bench::record("pushFront ns/op",
+                      std::chrono::duration<double, std::nano>(filled - start).count() / keys.size());
+    }
+    std::vector<int> ranks = bench::makeKeys(bench::Distribution::Sorted, 1 << 16);
+    std::vector<int> victims = bench::makeKeys(bench::Distribution::Zipf, 1 << 12);
+    SinglyLinkedList list;
+    for (int key : ranks) {
+        list.pushBack(key);
+    }
+    start = std::chrono::steady_clock::now();
+    std::size_t removed = 0;
+    for (int key : victims) {
+        removed += list.remove(key) ? 1 : 0;
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "  remove " << victims.size() << " Zipf-distributed values from " << ranks.size() << " nodes "
+              << ms(start, end) << " ms (" << removed << " found)\n";
+    bench::record("remove us/op", std::chrono::duration<double, std::micro>(end - start).count() / victims.size());
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("linked_list", argc, argv);
+        suite.run("list", runListBenchmark);
+        return suite.finish();
+    }
+
     SinglyLinkedList list;
 
     list.pushBack(10);
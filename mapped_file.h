@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DSA_HAVE_MMAP 1
+#endif
+
+#if defined(DSA_HAVE_MMAP)
+// Read-only memory map of a whole file, shared by the demos that read their input in place (edge
+// lists, sorted int runs, expression text, hash-map snapshots). Each of them layers a typed view on
+// top that checks size() against its record layout and reads straight from data(), so nothing is
+// parsed or copied and the kernel pages the file in as it is touched.
+class MappedFile {
+public:
+    // Sequential asks the kernel for aggressive readahead; Random leaves paging at its default.
+    enum class Access { Sequential, Random };
+
+    // description names the file in error messages, e.g. "Cannot open edge list: graph.edges".
+    MappedFile(const std::string& path, const std::string& description, Access access = Access::Sequential) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + description + ": " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot read " + description + ": " + path);
+        }
+        length = static_cast<std::size_t>(info.st_size);
+        if (length == 0) {
+            // mmap rejects empty mappings; an empty file is simply an empty range with no data().
+            ::close(fd);
+            return;
+        }
+        void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        // The mapping keeps the file contents reachable, so the descriptor is no longer needed.
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("Cannot map " + description + ": " + path);
+        }
+        if (access == Access::Sequential) {
+            ::madvise(mapped, length, MADV_SEQUENTIAL);
+        }
+        bytes = static_cast<const char*>(mapped);
+    }
+
+    ~MappedFile() {
+        if (bytes) {
+            ::munmap(const_cast<char*>(bytes), length);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Page-aligned, so any record type can be read from it in place; null for an empty file.
+    const char* data() const {
+        return bytes;
+    }
+
+    std::size_t size() const {
+        return length;
+    }
+
+private:
+    const char* bytes = nullptr;
+    std::size_t length = 0;
+};
+#endif
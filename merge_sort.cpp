@@ -1,17 +1,69 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include "bench_harness.h"
+#include "mapped_file.h"
+
+#if defined(DSA_HAVE_MMAP)
+// IntFileWriter writes run files through the descriptor API.
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+// GCC 12's AVX-512 headers trip a false -Wmaybe-uninitialized on _mm512_undefined (GCC bug 105593).
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#else
+#include <immintrin.h>
+#endif
+#endif
+
 // This program showcases merge sort on an integer vector. Merge sort uses a divide-and-conquer
 // strategy: split the array into halves, recursively sort each half, then merge the two sorted
 // halves into a single sorted run. The merging stage maintains order by repeatedly taking the
 // smallest remaining element from either half, yielding O(n log n) time with stable behavior.
+//
+// The two halves of every split are independent, which makes merge sort a natural fit for fork-join
+// parallelism. parallelMergeSort runs the splits as tasks on a work-stealing pool, and because the
+// final merges would otherwise run on one thread over the whole array, large merges are themselves
+// cut into independent pieces by co-ranking (the "merge path" technique).
+//
+// fastMergeSort tunes the sequential algorithm instead: insertion sort for small leaves, a branch-free
+// or SIMD bitonic merge kernel, and ping-pong buffers that drop the copy back after every merge. The
+// SIMD kernel is compiled in when the build targets AVX2 or AVX-512 (for example -march=native).
+//
+// externalMergeSort handles inputs larger than memory: it sorts memory-sized runs with fastMergeSort,
+// spills them to disk, and merges them back with a k-way heap over memory-mapped run files.
+//
+// mergeSortBy, radixSortBy, and sortBy sort arbitrary records by an extracted key, moving rather than
+// copying them; integer and floating-point keys can take an LSD radix sort instead of comparisons.
 
-void merge(std::vector<int>& values, std::vector<int>& buffer, int left, int mid, int right) {
+void merge(std::vector<int>& values, std::vector<int>& buffer, std::size_t left, std::size_t mid, std::size_t right) {
     // Indices i and j walk the left and right sorted halves respectively, while k tracks the
-    // destination slot in the temporary buffer.
-    int i = left;
-    int j = mid + 1;
-    int k = left;
+    // destination slot in the temporary buffer. std::size_t keeps arrays beyond 2^31 elements reachable.
+    std::size_t i = left;
+    std::size_t j = mid + 1;
+    std::size_t k = left;
 
     while (i <= mid && j <= right) {
         // Pick the smaller head element to maintain the merged run in sorted order.
@@ -32,17 +84,17 @@ void merge(std::vector<int>& values, std::vector<int>& buffer, int left, int mid
     }
 
     // Materialize the merged segment back into the original array so parent recursions see sorted data.
-    for (int idx = left; idx <= right; ++idx) {
+    for (std::size_t idx = left; idx <= right; ++idx) {
         values[idx] = buffer[idx];
     }
 }
 
-void mergeSortRecursive(std::vector<int>& values, std::vector<int>& buffer, int left, int right) {
+void mergeSortRecursive(std::vector<int>& values, std::vector<int>& buffer, std::size_t left, std::size_t right) {
     if (left >= right) {
         return;
     }
     // Split the interval in half; recursion sorts each side before the merge step rebuilds order.
-    int mid = left + (right - left) / 2;
+    std::size_t mid = left + (right - left) / 2;
     mergeSortRecursive(values, buffer, left, mid);
     mergeSortRecursive(values, buffer, mid + 1, right);
     merge(values, buffer, left, mid, right);
@@ -54,10 +106,1095 @@ void mergeSort(std::vector<int>& values) {
     }
     // A single reusable buffer avoids repeated allocations while giving merge() scratch space.
     std::vector<int> buffer(values.size());
-    mergeSortRecursive(values, buffer, 0, static_cast<int>(values.size()) - 1);
+    mergeSortRecursive(values, buffer, 0, values.size() - 1);
+}
+
+// Fork-join scheduler with one task deque per worker. A thread that forks pushes the second half of
+// the work onto the bottom of its own deque and keeps running the first half; idle workers steal from
+// the top of someone else's deque. Owners therefore work depth-first on small, cache-warm tasks while
+// thieves take the oldest, largest ones, which is what keeps stealing rare. Each deque has its own
+// mutex: tasks here are coarse (thousands of elements each), so the lock is never the bottleneck and
+// the scheduler stays easy to reason about compared with a lock-free Chase-Lev deque.
+class WorkStealingPool {
+public:
+    // Slot 0 is shared by every outside thread that calls invoke; threads - 1 workers fill the other slots.
+    explicit WorkStealingPool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+        : slots(std::max<std::size_t>(threads, 1)) {
+        for (std::size_t index = 1; index < slots.size(); ++index) {
+            workers.emplace_back([this, index] { workerLoop(index); });
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    std::size_t threadCount() const {
+        return slots.size();
+    }
+
+    // Runs first and second, possibly in parallel, and returns once both have finished. second is
+    // offered to thieves while first runs here; if nobody took it, it runs here too, so a pool with no
+    // idle workers degenerates to plain recursion. The callables must not throw.
+    template <typename First, typename Second>
+    void invoke(First&& first, Second&& second) {
+        using SecondType = std::remove_reference_t<Second>;
+        Task task;
+        task.run = [](void* context) { (*static_cast<SecondType*>(context))(); };
+        task.context = &second;
+        std::size_t self = currentSlot();
+        push(self, &task);
+        first();
+        if (popIf(self, &task)) {
+            second();
+            return;
+        }
+        // second was stolen, or, when several outside threads share slot 0, another thread's task now sits
+        // above it. Help with any queued work, our own slot included, until second is done: if nobody else
+        // holds it, this loop eventually runs it, so even a pool with no workers cannot spin forever.
+        while (!task.done.load(std::memory_order_acquire)) {
+            if (Task* other = steal(self)) {
+                execute(other);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    // Tasks live on the stack frame of the invoke that forked them, which cannot return before done.
+    struct Task {
+        void (*run)(void*) = nullptr;
+        void* context = nullptr;
+        std::atomic<bool> done{false};
+    };
+
+    // Padded so that neighbouring workers' deque locks never share a cache line.
+    struct alignas(64) Slot {
+        std::mutex lock;
+        std::deque<Task*> tasks;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> queued{0};
+    std::atomic<std::size_t> sleepers{0};
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    static thread_local const WorkStealingPool* currentPool;
+    static thread_local std::size_t currentIndex;
+
+    std::size_t currentSlot() const {
+        return currentPool == this ? currentIndex : 0;
+    }
+
+    void push(std::size_t self, Task* task) {
+        {
+            std::lock_guard<std::mutex> guard(slots[self].lock);
+            slots[self].tasks.push_back(task);
+        }
+        // Pairs with the sleeper's increment: with both sequentially consistent, either this thread sees
+        // the sleeper and wakes it, or the sleeper sees the new task and never goes to sleep.
+        queued.fetch_add(1);
+        if (sleepers.load() > 0) {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            wake.notify_one();
+        }
+    }
+
+    bool popIf(std::size_t self, Task* task) {
+        std::lock_guard<std::mutex> guard(slots[self].lock);
+        std::deque<Task*>& tasks = slots[self].tasks;
+        if (tasks.empty() || tasks.back() != task) {
+            return false;
+        }
+        tasks.pop_back();
+        queued.fetch_sub(1);
+        return true;
+    }
+
+    Task* steal(std::size_t self) {
+        // Scan the other slots starting after our own, so thieves spread out over different victims, and
+        // try our own slot last.
+        for (std::size_t offset = 1; offset <= slots.size(); ++offset) {
+            Slot& victim = slots[(self + offset) % slots.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                Task* task = victim.tasks.front();
+                victim.tasks.pop_front();
+                queued.fetch_sub(1);
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    static void execute(Task* task) {
+        task->run(task->context);
+        // The forking frame may destroy the task as soon as it sees done, so this is the last access.
+        task->done.store(true, std::memory_order_release);
+    }
+
+    void workerLoop(std::size_t index) {
+        currentPool = this;
+        currentIndex = index;
+        while (true) {
+            if (Task* task = steal(index)) {
+                execute(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(sleepLock);
+            sleepers.fetch_add(1);
+            wake.wait(guard, [this] { return stopping || queued.load() > 0; });
+            sleepers.fetch_sub(1);
+            if (stopping) {
+                return;
+            }
+        }
+    }
+};
+
+thread_local const WorkStealingPool* WorkStealingPool::currentPool = nullptr;
+thread_local std::size_t WorkStealingPool::currentIndex = 0;
+
+// Co-ranking: returns how many of the first k merged outputs come from a (the rest come from b). The
+// merged order takes a's element first on ties, matching merge() and keeping the sort stable. The
+// split lies where a[i] <= b[k - i - 1] stops holding, which is monotone in i, so binary search finds
+// it in O(log min(m, n)).
+std::size_t coRank(std::size_t k, const int* a, std::size_t m, const int* b, std::size_t n) {
+    std::size_t low = k > n ? k - n : 0;
+    std::size_t high = std::min(k, m);
+    while (low < high) {
+        std::size_t i = low + (high - low) / 2;
+        if (a[i] <= b[k - i - 1]) {
+            low = i + 1;
+        } else {
+            high = i;
+        }
+    }
+    return low;
+}
+
+// Below these sizes forking or splitting costs more than it saves, so the work runs sequentially.
+constexpr std::size_t kParallelSortCutoff = 1 << 14;
+constexpr std::size_t kParallelMergeGrain = 1 << 16;
+
+// Writes outputs [first, last) of merging a (length m) and b (length n) into out. Each half of the
+// output range finds its own starting point in both inputs by co-ranking, so pieces never coordinate.
+void parallelMergeRange(WorkStealingPool& pool, const int* a, std::size_t m, const int* b, std::size_t n, int* out,
+                        std::size_t first, std::size_t last) {
+    if (last - first > kParallelMergeGrain) {
+        std::size_t middle = first + (last - first) / 2;
+        pool.invoke([&] { parallelMergeRange(pool, a, m, b, n, out, first, middle); },
+                    [&] { parallelMergeRange(pool, a, m, b, n, out, middle, last); });
+        return;
+    }
+    std::size_t i = coRank(first, a, m, b, n);
+    std::size_t j = first - i;
+    std::size_t iEnd = coRank(last, a, m, b, n);
+    std::size_t jEnd = last - iEnd;
+    int* target = out + first;
+    while (i < iEnd && j < jEnd) {
+        if (a[i] <= b[j]) {
+            *target++ = a[i++];
+        } else {
+            *target++ = b[j++];
+        }
+    }
+    target = std::copy(a + i, a + iEnd, target);
+    std::copy(b + j, b + jEnd, target);
+}
+
+void parallelCopy(WorkStealingPool& pool, const int* from, int* to, std::size_t count) {
+    if (count > kParallelMergeGrain) {
+        std::size_t half = count / 2;
+        pool.invoke([&] { parallelCopy(pool, from, to, half); },
+                    [&] { parallelCopy(pool, from + half, to + half, count - half); });
+        return;
+    }
+    std::copy(from, from + count, to);
+}
+
+void parallelMergeSortRecursive(WorkStealingPool& pool, std::vector<int>& values, std::vector<int>& buffer,
+                                std::size_t left, std::size_t right) {
+    if (right - left + 1 <= kParallelSortCutoff) {
+        mergeSortRecursive(values, buffer, left, right);
+        return;
+    }
+    std::size_t mid = left + (right - left) / 2;
+    pool.invoke([&] { parallelMergeSortRecursive(pool, values, buffer, left, mid); },
+                [&] { parallelMergeSortRecursive(pool, values, buffer, mid + 1, right); });
+    // Same contract as merge(): merge into buffer, then copy the segment back, both split across tasks.
+    const int* a = values.data() + left;
+    const int* b = values.data() + mid + 1;
+    std::size_t m = mid + 1 - left;
+    std::size_t n = right - mid;
+    parallelMergeRange(pool, a, m, b, n, buffer.data() + left, 0, m + n);
+    parallelCopy(pool, buffer.data() + left, values.data() + left, m + n);
+}
+
+// Parallel, stable merge sort on an existing pool; produces exactly the same order as mergeSort.
+void parallelMergeSort(std::vector<int>& values, WorkStealingPool& pool) {
+    if (values.empty()) {
+        return;
+    }
+    std::vector<int> buffer(values.size());
+    parallelMergeSortRecursive(pool, values, buffer, 0, values.size() - 1);
+}
+
+void parallelMergeSort(std::vector<int>& values, std::size_t threads = std::thread::hardware_concurrency()) {
+    WorkStealingPool pool(threads);
+    parallelMergeSort(values, pool);
 }
 
-int main() {
+// Below this size a leaf is finished with insertion sort: the elements fit in a cache line or two and
+// there is no call overhead, which beats recursing all the way down to single elements.
+constexpr std::size_t kInsertionSortCutoff = 16;
+
+void insertionSort(int* values, std::size_t count) {
+    for (std::size_t i = 1; i < count; ++i) {
+        int value = values[i];
+        std::size_t j = i;
+        while (j > 0 && values[j - 1] > value) {
+            values[j] = values[j - 1];
+            --j;
+        }
+        values[j] = value;
+    }
+}
+
+// The same stable merge as merge(), but the choice of input becomes a 0/1 value that advances both
+// cursors arithmetically. The compiler emits conditional moves instead of a branch that random data
+// mispredicts about half the time.
+void mergeBranchless(const int* a, std::size_t m, const int* b, std::size_t n, int* out) {
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < m && j < n) {
+        int x = a[i];
+        int y = b[j];
+        // Strict comparison: ties take from a, which keeps equal keys in their original order.
+        bool takeB = y < x;
+        *out++ = takeB ? y : x;
+        i += !takeB;
+        j += takeB;
+    }
+    out = std::copy(a + i, a + m, out);
+    std::copy(b + j, b + n, out);
+}
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#define MERGE_SORT_HAVE_SIMD 1
+// Bitonic merging network on SIMD registers. Two sorted registers a and b form a bitonic sequence once
+// b is reversed; one min/max across them splits it into a low and a high bitonic half, and log2(width)
+// rounds of compare-exchange between lanes i and i ^ distance sort each half. Every round is a lane
+// permute, a min, a max, and a blend, with no data-dependent branches at all.
+#if defined(__AVX512F__)
+constexpr std::size_t kSimdWidth = 16;
+using SimdInts = __m512i;
+
+inline SimdInts simdLoad(const int* from) {
+    return _mm512_loadu_si512(from);
+}
+
+inline void simdStore(int* to, SimdInts value) {
+    _mm512_storeu_si512(to, value);
+}
+
+inline SimdInts simdReverse(SimdInts value) {
+    return _mm512_permutexvar_epi32(_mm512_set_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), value);
+}
+
+// Lanes whose index has the distance bit set keep the maximum of the pair, the others the minimum.
+template <int Distance>
+inline SimdInts compareExchange(SimdInts value) {
+    const __m512i lanes = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    SimdInts partner = _mm512_permutexvar_epi32(_mm512_xor_si512(lanes, _mm512_set1_epi32(Distance)), value);
+    __mmask16 upper = _mm512_test_epi32_mask(lanes, _mm512_set1_epi32(Distance));
+    return _mm512_mask_blend_epi32(upper, _mm512_min_epi32(value, partner), _mm512_max_epi32(value, partner));
+}
+
+inline SimdInts bitonicSort(SimdInts value) {
+    value = compareExchange<8>(value);
+    value = compareExchange<4>(value);
+    value = compareExchange<2>(value);
+    return compareExchange<1>(value);
+}
+
+inline SimdInts simdMin(SimdInts a, SimdInts b) {
+    return _mm512_min_epi32(a, b);
+}
+
+inline SimdInts simdMax(SimdInts a, SimdInts b) {
+    return _mm512_max_epi32(a, b);
+}
+#else
+constexpr std::size_t kSimdWidth = 8;
+using SimdInts = __m256i;
+
+inline SimdInts simdLoad(const int* from) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from));
+}
+
+inline void simdStore(int* to, SimdInts value) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(to), value);
+}
+
+inline SimdInts simdReverse(SimdInts value) {
+    return _mm256_permutevar8x32_epi32(value, _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+// Lanes whose index has the distance bit set keep the maximum of the pair, the others the minimum.
+template <int Distance>
+inline SimdInts compareExchange(SimdInts value) {
+    const __m256i lanes = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    SimdInts partner = _mm256_permutevar8x32_epi32(value, _mm256_xor_si256(lanes, _mm256_set1_epi32(Distance)));
+    constexpr int upper = Distance == 4 ? 0xF0 : Distance == 2 ? 0xCC : 0xAA;
+    return _mm256_blend_epi32(_mm256_min_epi32(value, partner), _mm256_max_epi32(value, partner), upper);
+}
+
+inline SimdInts bitonicSort(SimdInts value) {
+    value = compareExchange<4>(value);
+    value = compareExchange<2>(value);
+    return compareExchange<1>(value);
+}
+
+inline SimdInts simdMin(SimdInts a, SimdInts b) {
+    return _mm256_min_epi32(a, b);
+}
+
+inline SimdInts simdMax(SimdInts a, SimdInts b) {
+    return _mm256_max_epi32(a, b);
+}
+#endif
+
+// Leaves the kSimdWidth smallest values of low and high, sorted, in low and the rest in high.
+inline void bitonicMerge(SimdInts& low, SimdInts& high) {
+    SimdInts reversed = simdReverse(high);
+    SimdInts smaller = simdMin(low, reversed);
+    SimdInts larger = simdMax(low, reversed);
+    low = bitonicSort(smaller);
+    high = bitonicSort(larger);
+}
+
+// Streams two sorted runs through the network one register at a time. After each network pass the
+// low register is final, because the next block comes from whichever input has the smaller next
+// value and every unread value is at least that large. Equal ints are indistinguishable, so the
+// network's instability cannot be observed and the output matches the stable merges exactly.
+void mergeBitonic(const int* a, std::size_t m, const int* b, std::size_t n, int* out) {
+    constexpr std::size_t W = kSimdWidth;
+    if (m < W || n < W) {
+        mergeBranchless(a, m, b, n, out);
+        return;
+    }
+    SimdInts low = simdLoad(a);
+    SimdInts high = simdLoad(b);
+    std::size_t i = W;
+    std::size_t j = W;
+    bool fromA;
+    while (true) {
+        bitonicMerge(low, high);
+        simdStore(out, low);
+        out += W;
+        fromA = j >= n || (i < m && a[i] <= b[j]);
+        if (fromA) {
+            if (m - i < W) {
+                break;
+            }
+            low = simdLoad(a + i);
+            i += W;
+        } else {
+            if (n - j < W) {
+                break;
+            }
+            low = simdLoad(b + j);
+            j += W;
+        }
+    }
+    // high still holds W pending values. Merging is associative, so fold them into the short tail of
+    // the input that could not supply a full block, then merge that with the other input's remainder.
+    int pending[W];
+    int combined[2 * W];
+    simdStore(pending, high);
+    if (fromA) {
+        mergeBranchless(pending, W, a + i, m - i, combined);
+        mergeBranchless(combined, W + (m - i), b + j, n - j, out);
+    } else {
+        mergeBranchless(pending, W, b + j, n - j, combined);
+        mergeBranchless(combined, W + (n - j), a + i, m - i, out);
+    }
+}
+#endif
+
+enum class MergeKernel {
+    Branchless, // mergeBranchless
+    Bitonic     // mergeBitonic where the build enables AVX2 or AVX-512, otherwise mergeBranchless
+};
+
+// Ping-pong recursion: sorts values[0, count) and leaves the result in scratch when intoScratch is
+// set, in values otherwise. Each level asks its children for the opposite placement, so every merge
+// reads from one array and writes into the other, and merge()'s copy back after each merge disappears.
+template <typename MergeRuns>
+void pingPongSort(int* values, int* scratch, std::size_t count, bool intoScratch, MergeRuns mergeRuns) {
+    if (count <= kInsertionSortCutoff) {
+        insertionSort(values, count);
+        if (intoScratch) {
+            std::copy(values, values + count, scratch);
+        }
+        return;
+    }
+    std::size_t half = count / 2;
+    pingPongSort(values, scratch, half, !intoScratch, mergeRuns);
+    pingPongSort(values + half, scratch + half, count - half, !intoScratch, mergeRuns);
+    const int* from = intoScratch ? values : scratch;
+    int* to = intoScratch ? scratch : values;
+    mergeRuns(from, half, from + half, count - half, to);
+}
+
+// Drop-in replacement for mergeSort with the same (stable) result: insertion-sorted leaves, ping-pong
+// buffers, and a branchless or SIMD merge kernel.
+void fastMergeSort(std::vector<int>& values, MergeKernel kernel = MergeKernel::Bitonic) {
+    if (values.size() < 2) {
+        return;
+    }
+    std::vector<int> scratch(values.size());
+#if defined(MERGE_SORT_HAVE_SIMD)
+    if (kernel == MergeKernel::Bitonic) {
+        pingPongSort(values.data(), scratch.data(), values.size(), false, mergeBitonic);
+        return;
+    }
+#endif
+    (void)kernel;
+    pingPongSort(values.data(), scratch.data(), values.size(), false, mergeBranchless);
+}
+
+// Times mergeSort against parallelMergeSort at a few thread counts on the same random input.
+void runSortBenchmark() {
+    const std::size_t count = 1 << 24;
+    std::vector<int> input = bench::makeKeys(bench::Distribution::Uniform, count, 31);
+    std::vector<int> expected = input;
+    std::sort(expected.begin(), expected.end());
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+
+    std::cout << "Sort benchmark: " << count << " random ints (" << std::thread::hardware_concurrency()
+              << " hardware threads)\n";
+    std::vector<int> data = input;
+    auto start = std::chrono::steady_clock::now();
+    mergeSort(data);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "  mergeSort " << ms(start, end) << " ms" << (data == expected ? "" : " WRONG") << "\n";
+    bench::record("mergeSort ns/element", ms(start, end) * 1e6 / count);
+    for (std::size_t threads : {1, 2, 4, 8}) {
+        data = input;
+        WorkStealingPool pool(threads);
+        start = std::chrono::steady_clock::now();
+        parallelMergeSort(data, pool);
+        end = std::chrono::steady_clock::now();
+        std::cout << "  parallelMergeSort, " << threads << " threads " << ms(start, end) << " ms"
+                  << (data == expected ? "" : " WRONG") << "\n";
+        bench::record("parallelMergeSort " + std::to_string(threads) + " threads ns/element",
+                      ms(start, end) * 1e6 / count);
+    }
+}
+
+// Generic record sorting. Records are ordered by a key extracted from each one, so callers sort structs
+// by a field without writing a comparator over whole records, and every element is moved, never
+// copied, which keeps records with heap-owned members (strings, vectors) cheap to sort.
+//
+// mergeSortBy is the same ping-pong merge sort as fastMergeSort, generalized to any random-access range
+// and any strict weak ordering on the keys; like mergeSort it is stable.
+
+template <typename Iterator, typename KeyOf, typename Compare>
+void insertionSortBy(Iterator first, std::size_t count, KeyOf& key, Compare& compare) {
+    for (std::size_t i = 1; i < count; ++i) {
+        auto value = std::move(first[i]);
+        std::size_t j = i;
+        while (j > 0 && compare(key(value), key(first[j - 1]))) {
+            first[j] = std::move(first[j - 1]);
+            --j;
+        }
+        first[j] = std::move(value);
+    }
+}
+
+// Stable merge that moves records from [a, a + m) and [b, b + n) into out.
+template <typename From, typename To, typename KeyOf, typename Compare>
+void mergeBy(From a, std::size_t m, From b, std::size_t n, To out, KeyOf& key, Compare& compare) {
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < m && j < n) {
+        // Only a strictly smaller right-hand key goes first, so equal keys keep their input order.
+        if (compare(key(b[j]), key(a[i]))) {
+            *out++ = std::move(b[j++]);
+        } else {
+            *out++ = std::move(a[i++]);
+        }
+    }
+    out = std::move(a + i, a + m, out);
+    std::move(b + j, b + n, out);
+}
+
+// Ping-pong recursion between the caller's range and one scratch array, as in pingPongSort.
+template <typename Iterator, typename Scratch, typename KeyOf, typename Compare>
+void pingPongSortBy(Iterator values, Scratch scratch, std::size_t count, bool intoScratch, KeyOf& key,
+                    Compare& compare) {
+    if (count <= kInsertionSortCutoff) {
+        insertionSortBy(values, count, key, compare);
+        if (intoScratch) {
+            std::move(values, values + count, scratch);
+        }
+        return;
+    }
+    std::size_t half = count / 2;
+    pingPongSortBy(values, scratch, half, !intoScratch, key, compare);
+    pingPongSortBy(values + half, scratch + half, count - half, !intoScratch, key, compare);
+    if (intoScratch) {
+        mergeBy(values, half, values + half, count - half, scratch, key, compare);
+    } else {
+        mergeBy(scratch, half, scratch + half, count - half, values, key, compare);
+    }
+}
+
+// Stable sort of [first, last) by compare(key(a), key(b)). Records only need to be move-constructible
+// and move-assignable: the scratch array is move-constructed from the range itself, and the recursion
+// starts from that copy so the sorted result lands back in the caller's range.
+template <typename RandomIt, typename KeyOf, typename Compare = std::less<>>
+void mergeSortBy(RandomIt first, RandomIt last, KeyOf key, Compare compare = Compare()) {
+    using Record = typename std::iterator_traits<RandomIt>::value_type;
+    const std::size_t count = static_cast<std::size_t>(last - first);
+    if (count < 2) {
+        return;
+    }
+    std::vector<Record> scratch(std::make_move_iterator(first), std::make_move_iterator(last));
+    pingPongSortBy(scratch.begin(), first, count, true, key, compare);
+}
+
+// LSD radix sort needs keys as unsigned integers whose order matches the key order. Unsigned keys are
+// used as they are, signed keys get their sign bit flipped so negatives come first, and IEEE floats
+// flip the sign bit of positives and every bit of negatives, which makes more negative values smaller.
+// NaN keys have no defined position, as with the comparison sorts.
+template <typename Key>
+auto radixBits(Key key) {
+    static_assert(std::is_arithmetic<Key>::value, "radix sort needs integer or floating-point keys");
+    if constexpr (std::is_floating_point<Key>::value) {
+        using Bits = std::conditional_t<sizeof(Key) == 8, std::uint64_t, std::uint32_t>;
+        static_assert(sizeof(Key) == sizeof(Bits), "unsupported floating-point width");
+        // -0.0 compares equal to 0.0, so it must land in the same place to keep the sort stable.
+        if (key == Key(0)) {
+            key = Key(0);
+        }
+        Bits bits;
+        std::memcpy(&bits, &key, sizeof bits);
+        const Bits sign = Bits(1) << (sizeof(Bits) * 8 - 1);
+        return (bits & sign) ? Bits(~bits) : Bits(bits | sign);
+    } else if constexpr (std::is_signed<Key>::value) {
+        using Bits = std::make_unsigned_t<Key>;
+        return static_cast<Bits>(static_cast<Bits>(key) ^ (Bits(1) << (sizeof(Bits) * 8 - 1)));
+    } else {
+        return key;
+    }
+}
+
+// 11-bit digits: 2048 counters per digit stay within L1, and a 64-bit key needs 6 passes instead of
+// the 8 that byte-sized digits would take.
+constexpr unsigned kRadixBits = 11;
+
+// Stable LSD radix sort of [first, last) by an integer or floating-point key, ascending. One counting
+// pass builds the histograms of every digit at once; each scatter pass then moves all records between
+// the range and a single scratch array. Digits on which every key agrees are skipped, which is common
+// in practice: nanosecond timestamps from one day share their top 17 bits, so sorting them scatters
+// 5 of the 6 digits.
+template <typename RandomIt, typename KeyOf>
+void radixSortBy(RandomIt first, RandomIt last, KeyOf key) {
+    using Record = typename std::iterator_traits<RandomIt>::value_type;
+    using Key = std::decay_t<decltype(key(*first))>;
+    using Bits = decltype(radixBits(Key()));
+    constexpr unsigned digits = (sizeof(Bits) * 8 + kRadixBits - 1) / kRadixBits;
+    constexpr std::size_t buckets = std::size_t(1) << kRadixBits;
+    const std::size_t count = static_cast<std::size_t>(last - first);
+    if (count < 2) {
+        return;
+    }
+
+    std::vector<std::size_t> histogram(digits * buckets, 0);
+    for (RandomIt it = first; it != last; ++it) {
+        Bits bits = radixBits(key(*it));
+        for (unsigned digit = 0; digit < digits; ++digit) {
+            ++histogram[digit * buckets + ((bits >> (digit * kRadixBits)) & (buckets - 1))];
+        }
+    }
+    std::vector<unsigned> passes;
+    for (unsigned digit = 0; digit < digits; ++digit) {
+        const std::size_t* counts = histogram.data() + digit * buckets;
+        if (std::find(counts, counts + buckets, count) == counts + buckets) {
+            passes.push_back(digit);
+        }
+    }
+    if (passes.empty()) {
+        return;
+    }
+
+    // As in mergeSortBy, the scratch array starts as a moved copy of the range and serves as the
+    // source of the first pass.
+    std::vector<Record> scratch(std::make_move_iterator(first), std::make_move_iterator(last));
+    bool inScratch = true;
+    auto scatter = [&](auto from, auto to, unsigned digit) {
+        // Exclusive prefix sums turn the digit's counts into starting offsets.
+        std::size_t* offsets = histogram.data() + digit * buckets;
+        std::size_t sum = 0;
+        for (std::size_t bucket = 0; bucket < buckets; ++bucket) {
+            std::size_t next = sum + offsets[bucket];
+            offsets[bucket] = sum;
+            sum = next;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            std::size_t bucket = (radixBits(key(from[i])) >> (digit * kRadixBits)) & (buckets - 1);
+            to[offsets[bucket]++] = std::move(from[i]);
+        }
+    };
+    for (unsigned digit : passes) {
+        if (inScratch) {
+            scatter(scratch.begin(), first, digit);
+        } else {
+            scatter(first, scratch.begin(), digit);
+        }
+        inScratch = !inScratch;
+    }
+    if (inScratch) {
+        std::move(scratch.begin(), scratch.end(), first);
+    }
+}
+
+// Stable ascending sort by key that picks the algorithm: LSD radix sort for integer and floating-point
+// keys once the input is large enough to amortize the histograms, the comparison merge sort otherwise.
+template <typename RandomIt, typename KeyOf>
+void sortBy(RandomIt first, RandomIt last, KeyOf key) {
+    using Key = std::decay_t<decltype(key(*first))>;
+    if constexpr (std::is_arithmetic<Key>::value && !std::is_same<Key, bool>::value) {
+        if (last - first >= 256) {
+            radixSortBy(first, last, key);
+            return;
+        }
+    }
+    mergeSortBy(first, last, key);
+}
+
+#if defined(DSA_HAVE_MMAP)
+// Read-only memory map of a file of native-endian ints. The merge phases read every run strictly
+// front to back, so the kernel's readahead turns the mapping into large sequential reads.
+class MappedInts {
+public:
+    explicit MappedInts(const std::string& path) : file(path, "int file") {
+        if (file.size() % sizeof(int) != 0) {
+            throw std::runtime_error("File is not a whole number of ints: " + path);
+        }
+    }
+
+    const int* data() const {
+        return reinterpret_cast<const int*>(file.data());
+    }
+
+    std::size_t size() const {
+        return file.size() / sizeof(int);
+    }
+
+private:
+    MappedFile file;
+};
+
+// Appends ints to a file through one large buffer, so the disk only ever sees big sequential writes.
+class IntFileWriter {
+public:
+    IntFileWriter(const std::string& path, std::size_t bufferInts)
+        : path(path), buffer(std::max<std::size_t>(bufferInts, 1)) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot create " + path);
+        }
+    }
+
+    ~IntFileWriter() {
+        if (fd >= 0) {
+            // Destruction during stack unwinding must not throw; close() reports errors on the normal path.
+            ::close(fd);
+        }
+    }
+
+    IntFileWriter(const IntFileWriter&) = delete;
+    IntFileWriter& operator=(const IntFileWriter&) = delete;
+
+    void put(int value) {
+        if (used == buffer.size()) {
+            flush();
+        }
+        buffer[used++] = value;
+    }
+
+    void write(const int* values, std::size_t count) {
+        flush();
+        writeAll(values, count);
+    }
+
+    void close() {
+        flush();
+        int result = ::close(fd);
+        fd = -1;
+        if (result != 0) {
+            throw std::runtime_error("Cannot finish writing " + path);
+        }
+    }
+
+private:
+    std::string path;
+    std::vector<int> buffer;
+    std::size_t used = 0;
+    int fd = -1;
+
+    void flush() {
+        writeAll(buffer.data(), used);
+        used = 0;
+    }
+
+    void writeAll(const int* values, std::size_t count) {
+        const char* bytes = reinterpret_cast<const char*>(values);
+        std::size_t remaining = count * sizeof(int);
+        while (remaining > 0) {
+            ssize_t written = ::write(fd, bytes, remaining);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Cannot write " + path);
+            }
+            bytes += written;
+            remaining -= static_cast<std::size_t>(written);
+        }
+    }
+};
+
+// A sorted run inside a spill file, in ints.
+struct SortedRun {
+    std::size_t offset;
+    std::size_t length;
+};
+
+// Binary min-heap over the heads of the runs being merged, keyed by (value, run) so that equal values
+// leave in run order. This is the min half of MinMaxHeap from min_max_heap.cpp, trimmed to what a
+// k-way merge needs: replaceTop swaps in the next value of the run just consumed with a single
+// sift-down instead of a pop followed by a push.
+class RunHeap {
+public:
+    struct Head {
+        int value;
+        std::size_t run;
+    };
+
+    bool empty() const {
+        return heads.empty();
+    }
+
+    const Head& top() const {
+        return heads.front();
+    }
+
+    void push(Head head) {
+        heads.push_back(head);
+        std::size_t index = heads.size() - 1;
+        while (index > 0) {
+            std::size_t parent = (index - 1) / 2;
+            if (!less(heads[index], heads[parent])) {
+                break;
+            }
+            std::swap(heads[index], heads[parent]);
+            index = parent;
+        }
+    }
+
+    void replaceTop(int value) {
+        heads.front().value = value;
+        siftDown();
+    }
+
+    void popTop() {
+        heads.front() = heads.back();
+        heads.pop_back();
+        if (!heads.empty()) {
+            siftDown();
+        }
+    }
+
+private:
+    std::vector<Head> heads;
+
+    static bool less(const Head& a, const Head& b) {
+        return a.value < b.value || (a.value == b.value && a.run < b.run);
+    }
+
+    void siftDown() {
+        std::size_t index = 0;
+        const std::size_t count = heads.size();
+        while (true) {
+            std::size_t smallest = index;
+            std::size_t left = 2 * index + 1;
+            if (left < count && less(heads[left], heads[smallest])) {
+                smallest = left;
+            }
+            if (left + 1 < count && less(heads[left + 1], heads[smallest])) {
+                smallest = left + 1;
+            }
+            if (smallest == index) {
+                return;
+            }
+            std::swap(heads[index], heads[smallest]);
+            index = smallest;
+        }
+    }
+};
+
+// Merges runs (all stored in data) into out with a heap of run heads, one value at a time.
+void mergeSortedRuns(const int* data, const std::vector<SortedRun>& runs, IntFileWriter& out) {
+    std::vector<const int*> next(runs.size());
+    std::vector<const int*> end(runs.size());
+    RunHeap heap;
+    for (std::size_t run = 0; run < runs.size(); ++run) {
+        next[run] = data + runs[run].offset;
+        end[run] = next[run] + runs[run].length;
+        if (next[run] != end[run]) {
+            heap.push({*next[run]++, run});
+        }
+    }
+    while (!heap.empty()) {
+        RunHeap::Head head = heap.top();
+        out.put(head.value);
+        if (next[head.run] != end[head.run]) {
+            heap.replaceTop(*next[head.run]++);
+        } else {
+            heap.popTop();
+        }
+    }
+}
+
+// Out-of-core sort of a file of native-endian ints into output, using about memoryBytes of RAM.
+//   1. Run formation: cut the input into chunks that fit in memory together with fastMergeSort's
+//      scratch buffer, sort each chunk in memory, and append it to a spill file as one sorted run.
+//   2. Merging: k-way merge up to fanIn runs at a time with RunHeap. If there are more runs than that,
+//      intermediate passes merge groups into a second spill file until one final pass remains.
+// Input and spill files are read through read-only mappings, and all writes go through a large
+// sequential buffer. The spill files are created next to tempPrefix and removed afterwards.
+void externalMergeSort(const std::string& input, const std::string& output, std::size_t memoryBytes,
+                       const std::string& tempPrefix, std::size_t fanIn = 256) {
+    // Half the budget holds the chunk and half its scratch; the merge phase reuses it as write buffer.
+    const std::size_t chunkInts = std::max<std::size_t>(memoryBytes / (2 * sizeof(int)), 1024);
+    const std::size_t writeInts = std::max<std::size_t>(memoryBytes / (4 * sizeof(int)), 1024);
+    fanIn = std::max<std::size_t>(fanIn, 2);
+    // The spill files are removed however the sort ends: a throw from a write, a close, or a mapping
+    // (a full disk, say) would otherwise leave run files as large as the input behind.
+    struct SpillFiles {
+        std::string path[2];
+
+        ~SpillFiles() {
+            ::unlink(path[0].c_str());
+            ::unlink(path[1].c_str());
+        }
+    } spill{{tempPrefix + ".runs0", tempPrefix + ".runs1"}};
+
+    std::vector<SortedRun> runs;
+    {
+        MappedInts source(input);
+        if (source.size() <= chunkInts) {
+            // Everything fits in memory: no runs to spill.
+            std::vector<int> values(source.data(), source.data() + source.size());
+            fastMergeSort(values);
+            IntFileWriter out(output, writeInts);
+            out.write(values.data(), values.size());
+            out.close();
+            return;
+        }
+        IntFileWriter out(spill.path[0], writeInts);
+        std::vector<int> chunk;
+        for (std::size_t offset = 0; offset < source.size(); offset += chunkInts) {
+            std::size_t length = std::min(chunkInts, source.size() - offset);
+            chunk.assign(source.data() + offset, source.data() + offset + length);
+            fastMergeSort(chunk);
+            out.write(chunk.data(), chunk.size());
+            runs.push_back({offset, length});
+        }
+        out.close();
+    }
+
+    int current = 0;
+    while (runs.size() > fanIn) {
+        // Intermediate pass: every group of fanIn runs becomes one longer run in the other spill file.
+        MappedInts data(spill.path[current]);
+        IntFileWriter out(spill.path[1 - current], writeInts);
+        std::vector<SortedRun> merged;
+        for (std::size_t first = 0; first < runs.size(); first += fanIn) {
+            std::vector<SortedRun> group(runs.begin() + first, runs.begin() + std::min(first + fanIn, runs.size()));
+            SortedRun combined{group.front().offset, 0};
+            for (const SortedRun& run : group) {
+                combined.length += run.length;
+            }
+            // Runs are stored back to back, so the merged run lands at the group's starting offset.
+            mergeSortedRuns(data.data(), group, out);
+            merged.push_back(combined);
+        }
+        out.close();
+        runs = std::move(merged);
+        current = 1 - current;
+    }
+    {
+        MappedInts data(spill.path[current]);
+        IntFileWriter out(output, writeInts);
+        mergeSortedRuns(data.data(), runs, out);
+        out.close();
+    }
+}
+#endif
+
+// Times the sequential kernels against mergeSort and std::sort on the same random input.
+void runKernelBenchmark() {
+    const std::size_t count = 1 << 24;
+    std::vector<int> input = bench::makeKeys(bench::Distribution::Uniform, count, 37);
+    std::vector<int> expected = input;
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    auto start = std::chrono::steady_clock::now();
+    std::sort(expected.begin(), expected.end());
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Kernel benchmark: " << count << " random ints\n  std::sort " << ms(start, end) << " ms\n";
+    bench::record("std::sort ns/element", ms(start, end) * 1e6 / count);
+
+    auto time = [&](const char* name, auto sort) {
+        std::vector<int> data = input;
+        auto from = std::chrono::steady_clock::now();
+        sort(data);
+        auto to = std::chrono::steady_clock::now();
+        std::cout << "  " << name << " " << ms(from, to) << " ms" << (data == expected ? "" : " WRONG") << "\n";
+        bench::record(std::string(name) + " ns/element", ms(from, to) * 1e6 / count);
+    };
+    time("mergeSort", [](std::vector<int>& data) { mergeSort(data); });
+    time("fastMergeSort, branchless", [](std::vector<int>& data) { fastMergeSort(data, MergeKernel::Branchless); });
+#if defined(MERGE_SORT_HAVE_SIMD)
+    time(kSimdWidth == 16 ? "fastMergeSort, AVX-512 bitonic" : "fastMergeSort, AVX2 bitonic",
+         [](std::vector<int>& data) { fastMergeSort(data, MergeKernel::Bitonic); });
+#endif
+}
+
+// Sorts 4M event records by a 64-bit nanosecond timestamp spanning one day (millisecond resolution, so
+// keys repeat) with std::stable_sort, mergeSortBy, and radixSortBy, and checks that all three are stable.
+void runRecordSortBenchmark() {
+    struct Event {
+        std::uint64_t timestamp;
+        std::uint32_t source;
+        std::uint32_t sequence;
+    };
+    const std::size_t count = 1 << 22;
+    std::vector<Event> input(count);
+    bench::Rng rng(43);
+    const std::uint64_t dayStart = 1700000000000000000ULL;
+    for (std::size_t i = 0; i < count; ++i) {
+        input[i] = {dayStart + rng.below(86400000) * 1000000, static_cast<std::uint32_t>(rng.below(64)),
+                    static_cast<std::uint32_t>(i)};
+    }
+    auto timestampOf = [](const Event& event) { return event.timestamp; };
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    auto stableAndSorted = [](const std::vector<Event>& events) {
+        for (std::size_t i = 1; i < events.size(); ++i) {
+            const Event& a = events[i - 1];
+            const Event& b = events[i];
+            if (a.timestamp > b.timestamp || (a.timestamp == b.timestamp && a.sequence > b.sequence)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    auto time = [&](const char* name, auto sort) {
+        std::vector<Event> events = input;
+        auto start = std::chrono::steady_clock::now();
+        sort(events);
+        auto end = std::chrono::steady_clock::now();
+        std::cout << "  " << name << " " << ms(start, end) << " ms" << (stableAndSorted(events) ? "" : " WRONG")
+                  << "\n";
+        bench::record(std::string(name) + " ns/record", ms(start, end) * 1e6 / count);
+    };
+    std::cout << "Record sort benchmark: " << count << " 16-byte events by 64-bit timestamp\n";
+    time("std::stable_sort", [](std::vector<Event>& events) {
+        std::stable_sort(events.begin(), events.end(),
+                         [](const Event& a, const Event& b) { return a.timestamp < b.timestamp; });
+    });
+    time("mergeSortBy", [&](std::vector<Event>& events) { mergeSortBy(events.begin(), events.end(), timestampOf); });
+    time("radixSortBy", [&](std::vector<Event>& events) { radixSortBy(events.begin(), events.end(), timestampOf); });
+}
+
+#if defined(DSA_HAVE_MMAP)
+// Sorts a 64M-int (256 MiB) file in memory and externally with a 32 MiB budget, which forces 16 runs,
+// and again with fanIn 4 to add an intermediate merge pass.
+void runExternalBenchmark() {
+    const std::size_t count = 1 << 26;
+    const std::string input = "merge_sort_bench.in";
+    const std::string output = "merge_sort_bench.out";
+    std::vector<int> values = bench::makeKeys(bench::Distribution::Uniform, count, 41);
+    {
+        IntFileWriter writer(input, 1 << 20);
+        writer.write(values.data(), values.size());
+        writer.close();
+    }
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    auto start = std::chrono::steady_clock::now();
+    fastMergeSort(values);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "External sort benchmark: " << count << " ints\n  in memory " << ms(start, end) << " ms\n";
+    bench::record("in memory ns/element", ms(start, end) * 1e6 / count);
+    for (std::size_t fanIn : {256, 4}) {
+        start = std::chrono::steady_clock::now();
+        externalMergeSort(input, output, 32 << 20, output, fanIn);
+        end = std::chrono::steady_clock::now();
+        MappedInts sorted(output);
+        bool correct = sorted.size() == count && std::equal(values.begin(), values.end(), sorted.data());
+        std::cout << "  external, 32 MiB budget, fan-in " << fanIn << ": " << ms(start, end) << " ms"
+                  << (correct ? "" : " WRONG") << "\n";
+        bench::record("external fan-in " + std::to_string(fanIn) + " ns/element", ms(start, end) * 1e6 / count);
+    }
+    ::unlink(input.c_str());
+    ::unlink(output.c_str());
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("merge_sort", argc, argv);
+        suite.run("kernel", runKernelBenchmark);
+        suite.run("sort", runSortBenchmark);
+        suite.run("record_sort", runRecordSortBenchmark);
+#if defined(DSA_HAVE_MMAP)
+        suite.run("external", runExternalBenchmark);
+#endif
+        return suite.finish();
+    }
+#if defined(DSA_HAVE_MMAP)
+    if (argc > 3 && std::string(argv[1]) == "--external") {
+        // --external <input> <output> [memory MiB]: sort a binary file of native-endian ints.
+        std::size_t memoryMiB = argc > 4 ? std::stoul(argv[4]) : 1024;
+        try {
+            externalMergeSort(argv[2], argv[3], memoryMiB << 20, argv[3]);
+        } catch (const std::exception& ex) {
+            std::cerr << "External sort failed: " << ex.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+#endif
+
     std::vector<int> data = {38, 27, 43, 3, 9, 82, 10};
 
     std::cout << "Before sort: ";
@@ -75,5 +1212,27 @@ int main() {
     }
     std::cout << "\n";
 
+    // The parallel version gives the same result; on an input this small it never leaves the caller.
+    std::vector<int> again = {38, 27, 43, 3, 9, 82, 10};
+    parallelMergeSort(again, 4);
+    std::cout << "After parallel merge sort: ";
+    for (int number : again) {
+        std::cout << number << ' ';
+    }
+    std::cout << "\n";
+
+    // Records sort by any extracted key; equal ages keep their original order because the sort is stable.
+    struct Person {
+        std::string name;
+        int age;
+    };
+    std::vector<Person> people = {{"Ada", 36}, {"Brian", 29}, {"Chen", 36}, {"Dana", 22}, {"Eli", 29}};
+    sortBy(people.begin(), people.end(), [](const Person& person) { return person.age; });
+    std::cout << "People by age: ";
+    for (const Person& person : people) {
+        std::cout << person.name << " (" << person.age << ") ";
+    }
+    std::cout << "\n";
+
     return 0;
 }
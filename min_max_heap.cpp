@@ -1,124 +1,474 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "bench_harness.h"
+#include "cache_aligned_allocator.h"
+
 // This program demonstrates a Min-Max Heap, a double-ended priority queue that allows
 // both minimum and maximum elements to be accessed or removed in logarithmic time.
 // The heap stores elements in a vector representing a complete binary tree. Even-depth
 // levels obey min-heap ordering and odd-depth levels obey max-heap ordering, allowing us
 // to reach both extremes quickly without maintaining two separate heaps.
+
+// Depth of a node in the implicit binary tree, computed from the bit width of index + 1 in O(1).
+inline std::size_t levelOf(std::size_t index) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(63 - __builtin_clzll(static_cast<unsigned long long>(index) + 1));
+#else
+    std::size_t depth = 0;
+    for (std::size_t position = index + 1; position > 1; position >>= 1) {
+        ++depth;
+    }
+    return depth;
+#endif
+}
+
+// BinaryLayout stores logical node i at slot i: the classic level-order (Eytzinger) array, where a
+// node's children sit at 2i+1 and 2i+2 and its grandchildren at 4i+3 through 4i+6.
+struct BinaryLayout {
+    static std::size_t physical(std::size_t index) {
+        return index;
+    }
+
+    // Slot distance from the first node of an aligned sibling group (a node's two children or four
+    // grandchildren) to the k-th node of that group, given whether the group sits at an even depth.
+    static std::size_t groupOffset(bool, std::size_t k) {
+        return k;
+    }
+
+    // Slot of the first child of the node stored at slot, given whether that node sits at an even depth.
+    static std::size_t firstChildSlot(std::size_t slot, bool) {
+        return 2 * slot + 1;
+    }
+};
+
+// BlockedLayout groups each min-level node with its two max-level children into a "triangle" padded
+// to four slots. Triangles form a 4-ary tree stored in level order, so a min-level node's four
+// grandchildren are the roots of four consecutive triangles: sixteen slots, one 64-byte line for int.
+// A max-level node finds its children and grandchildren inside two of those triangles, also on one line.
+// Three leading padding triangles align every sibling group to a block boundary.
+struct BlockedLayout {
+    static constexpr std::size_t kTriangleSlots = 4;
+    static constexpr std::size_t kLeadingTriangles = 3;
+
+    static std::size_t physical(std::size_t index) {
+        std::size_t depth = levelOf(index);
+        std::size_t offset = index + 1 - (std::size_t(1) << depth);
+        std::size_t pairLevel = depth / 2;
+        // Triangles above this pair of levels number (4^pairLevel - 1) / 3.
+        std::size_t firstTriangle = ((std::size_t(1) << (2 * pairLevel)) - 1) / 3;
+        if (depth % 2 == 0) {
+            return (kLeadingTriangles + firstTriangle + offset) * kTriangleSlots;
+        }
+        // Odd depth: this node is child 0 or 1 inside its parent's triangle.
+        return (kLeadingTriangles + firstTriangle + offset / 2) * kTriangleSlots + 1 + (offset & 1);
+    }
+
+    static std::size_t groupOffset(bool evenDepth, std::size_t k) {
+        // Even-depth siblings are roots of consecutive triangles; odd-depth siblings pair up inside one.
+        if (evenDepth) {
+            return k * kTriangleSlots;
+        }
+        return (k / 2) * kTriangleSlots + (k & 1);
+    }
+
+    static std::size_t firstChildSlot(std::size_t slot, bool evenDepth) {
+        if (evenDepth) {
+            // A triangle root's children share its triangle.
+            return slot + 1;
+        }
+        // Child r (1 or 2) of triangle T owns child triangles 4(T - 3) + 2r - 1 and the one after it.
+        std::size_t r = slot % kTriangleSlots;
+        return kTriangleSlots * (slot + r - 10);
+    }
+};
+
+// The heap algorithms always reason about logical level-order indices; Layout only decides which
+// storage slot each logical node occupies. Compare orders values the way std::less does: getMin and
+// extractMin yield the element that compares before every other. T must be default-constructible
+// because BlockedLayout leaves padding slots in the storage.
+//
+// Every element gets a stable Handle when it enters the heap. The handle stays valid while the element
+// is stored, however it moves, and can be passed to update or erase. positions maps a handle to its
+// current logical index and slotHandles maps each storage slot back to its handle; the two are kept in
+// sync by the only two primitives that move elements, swapSlots and moveNode. Released handles are
+// recycled, so a handle must not be used after its element has been extracted or erased.
+// The index roughly triples the cost of a swap for int payloads, because every swap also touches two
+// positions at random; heaps that never update or erase can set TrackHandles to false to skip it.
+template <typename T = int, typename Compare = std::less<T>, typename Layout = BinaryLayout, bool TrackHandles = true>
 class MinMaxHeap {
 public:
-    void insert(int value) {
+    // 32-bit handles and positions keep the index to eight bytes per element.
+    using Handle = std::uint32_t;
+
+    explicit MinMaxHeap(Compare comparator = Compare()) : compare(std::move(comparator)) {}
+
+    // Builds the heap bottom-up in O(n) (Floyd's method, which Atkinson et al. showed carries over to
+    // min-max heaps): copy the values in as-is, then trickle down every internal node from the last
+    // parent back to the root. Each trickleDown only sees subtrees that are already valid heaps.
+    // The k-th value of the range receives handle k.
+    template <typename InputIt>
+    MinMaxHeap(InputIt first, InputIt last, Compare comparator = Compare()) : compare(std::move(comparator)) {
+        for (; first != last; ++first) {
+            append(*first);
+        }
+        repairFrom(0);
+    }
+
+    // Untracked heaps return 0.
+    Handle insert(T value) {
         // Append at the end to satisfy the array-based complete tree layout, then repair ordering.
-        data.push_back(value);
-        bubbleUp(data.size() - 1);
+        Handle handle = append(std::move(value));
+        bubbleUp(count - 1);
+        return handle;
     }
 
-    int getMin() const {
-        if (data.empty()) {
-            throw std::out_of_range("Heap is empty");
+    // Appends the whole batch and then repairs only the ancestors of the new nodes, one trickleDown
+    // each. Inserting k values costs O(k + log^2 n) instead of k separate O(log n) bubble-ups, and
+    // loading into an empty heap degenerates to the linear-time bulk build. Handles are returned in
+    // the order of the input range.
+    template <typename InputIt>
+    std::vector<Handle> insertBatch(InputIt first, InputIt last) {
+        std::size_t firstNew = count;
+        std::vector<Handle> handles;
+        for (; first != last; ++first) {
+            handles.push_back(append(*first));
         }
-        return data.front();
+        if (count > firstNew) {
+            repairFrom(firstNew);
+        }
+        return handles;
     }
 
-    int getMax() const {
-        if (data.empty()) {
+    const T& getMin() const {
+        if (empty()) {
             throw std::out_of_range("Heap is empty");
         }
-        if (data.size() == 1) {
-            return data.front();
+        return at(0);
+    }
+
+    const T& getMax() const {
+        if (empty()) {
+            throw std::out_of_range("Heap is empty");
         }
-        // The maximum element must be one of the root's children since level one stores the largest keys.
-        if (data.size() == 2) {
-            return data[1];
+        return at(maxIndex());
+    }
+
+    T extractMin() {
+        if (empty()) {
+            throw std::out_of_range("Heap is empty");
         }
-        return std::max(data[1], data[2]);
+        return removeAt(0);
     }
 
-    int extractMin() {
-        if (data.empty()) {
+    T extractMax() {
+        if (empty()) {
             throw std::out_of_range("Heap is empty");
         }
-        int minValue = data.front();
-        data[0] = data.back();
-        data.pop_back();
-        if (!data.empty()) {
-            // After moving the last element to the root, push it downward to restore heap invariants.
-            trickleDown(0);
+        return removeAt(maxIndex());
+    }
+
+    // Removes the n smallest values and returns them in ascending order.
+    std::vector<T> extractMinN(std::size_t n) {
+        return extractBatch(n, [this](const T& a, const T& b) { return compare(a, b); },
+                            [this] { return extractMin(); });
+    }
+
+    // Removes the n largest values and returns them in descending order.
+    std::vector<T> extractMaxN(std::size_t n) {
+        return extractBatch(n, [this](const T& a, const T& b) { return compare(b, a); },
+                            [this] { return extractMax(); });
+    }
+
+    const T& get(Handle handle) const {
+        static_assert(TrackHandles, "get requires a heap that tracks handles");
+        return at(positionOf(handle));
+    }
+
+    // Replaces the element's priority in place and moves it up or down as needed, which covers both
+    // decrease-key and increase-key without leaving a stale duplicate behind.
+    void update(Handle handle, T newValue) {
+        static_assert(TrackHandles, "update requires a heap that tracks handles");
+        std::size_t index = positionOf(handle);
+        at(index) = std::move(newValue);
+        repairAt(index);
+    }
+
+    // Removes an arbitrary element and returns its value.
+    T erase(Handle handle) {
+        static_assert(TrackHandles, "erase requires a heap that tracks handles");
+        return removeAt(positionOf(handle));
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+private:
+    static constexpr std::uint32_t kNoPosition = std::numeric_limits<std::uint32_t>::max();
+
+    // Storage for the complete binary tree; Layout maps each logical index to a slot in data, and
+    // slotHandles runs parallel to data.
+    std::vector<T, CacheAlignedAllocator<T>> data;
+    std::vector<Handle> slotHandles;
+    std::vector<std::uint32_t> positions;
+    std::vector<Handle> freeHandles;
+    std::size_t count = 0;
+    Compare compare;
+
+    T& at(std::size_t index) {
+        return data[Layout::physical(index)];
+    }
+
+    const T& at(std::size_t index) const {
+        return data[Layout::physical(index)];
+    }
+
+    std::size_t positionOf(Handle handle) const {
+        if (handle >= positions.size() || positions[handle] == kNoPosition) {
+            throw std::invalid_argument("Handle does not refer to an element in the heap");
+        }
+        return positions[handle];
+    }
+
+    // The maximum element must be one of the root's children since level one stores the largest keys.
+    std::size_t maxIndex() const {
+        if (count == 1) {
+            return 0;
+        }
+        if (count > 2 && compare(at(1), at(2))) {
+            return 2;
         }
-        return minValue;
+        return 1;
     }
 
-    int extractMax() {
-        if (data.empty()) {
-            throw std::out_of_range("Heap is empty");
+    Handle append(T value) {
+        Handle handle = 0;
+        if constexpr (TrackHandles) {
+            if (count >= kNoPosition) {
+                throw std::length_error("MinMaxHeap handles are limited to 32 bits");
+            }
+            if (freeHandles.empty()) {
+                handle = static_cast<Handle>(positions.size());
+                positions.push_back(kNoPosition);
+            } else {
+                handle = freeHandles.back();
+                freeHandles.pop_back();
+            }
         }
-        if (data.size() == 1) {
-            int maxValue = data.front();
-            data.pop_back();
-            return maxValue;
+        place(std::move(value), handle);
+        return handle;
+    }
+
+    // Stores value with its handle at the next logical index, growing storage to cover its slot.
+    void place(T value, Handle handle) {
+        std::size_t slot = Layout::physical(count);
+        if (slot >= data.size()) {
+            data.resize(slot + 1);
+            if constexpr (TrackHandles) {
+                slotHandles.resize(slot + 1);
+            }
         }
-        size_t maxIndex = 1;
-        if (data.size() > 2 && data[2] > data[1]) {
-            maxIndex = 2;
+        data[slot] = std::move(value);
+        if constexpr (TrackHandles) {
+            slotHandles[slot] = handle;
+            positions[handle] = static_cast<std::uint32_t>(count);
         }
-        int maxValue = data[maxIndex];
-        data[maxIndex] = data.back();
-        data.pop_back();
-        if (maxIndex < data.size()) {
-            // Trickle from the original child position because we replaced that slot with the last element.
-            trickleDown(maxIndex);
+        ++count;
+    }
+
+    Handle handleAt(std::size_t slot) const {
+        if constexpr (TrackHandles) {
+            return slotHandles[slot];
         }
-        return maxValue;
+        return 0;
     }
 
-    bool empty() const {
-        return data.empty();
+    void release(Handle handle) {
+        if constexpr (TrackHandles) {
+            positions[handle] = kNoPosition;
+            freeHandles.push_back(handle);
+        }
     }
 
-private:
-    // Array-backed complete binary tree where indices encode parent/child relationships.
-    std::vector<int> data;
+    // Takes the element at index out of the heap, fills the hole with the last element, and repairs
+    // around it. extractMin, extractMax, and erase all reduce to this.
+    T removeAt(std::size_t index) {
+        std::size_t slot = Layout::physical(index);
+        T value = std::move(data[slot]);
+        release(handleAt(slot));
+        --count;
+        if (index < count) {
+            moveNode(count, index);
+            repairAt(index);
+        }
+        return value;
+    }
+
+    // Restores heap order after the value at index changed arbitrarily while every other node stayed
+    // valid. If the value crossed its parent, swapping the two settles the parent's level by bubbling up,
+    // and the parent's old value, which dominates index's whole subtree, then trickles down from index.
+    // Otherwise the value either climbs its own level's chain or, if it stays put, trickles down.
+    void repairAt(std::size_t index) {
+        if (index > 0) {
+            std::size_t p = parent(index);
+            bool minLevel = isMinLevel(index);
+            if (minLevel ? compare(at(p), at(index)) : compare(at(index), at(p))) {
+                swapNodes(index, p);
+                if (minLevel) {
+                    bubbleUpMax(p);
+                } else {
+                    bubbleUpMin(p);
+                }
+                trickleDown(index);
+                return;
+            }
+        }
+        std::size_t settled = isMinLevel(index) ? bubbleUpMin(index) : bubbleUpMax(index);
+        if (settled == index) {
+            trickleDown(index);
+        }
+    }
+
+    // Restores heap order after nodes [firstNew, count) were appended without repair. The nodes that can
+    // violate the invariants are the new ones and their ancestors; at each step they form one contiguous
+    // index range, so the walk handles a range in decreasing index order (children before parents) and
+    // then moves to the parents not yet visited. firstNew == 0 visits every node: the bulk build.
+    void repairFrom(std::size_t firstNew) {
+        if (count == 0) {
+            return;
+        }
+        std::size_t low = firstNew;
+        std::size_t high = count - 1;
+        while (true) {
+            for (std::size_t index = high + 1; index-- > low;) {
+                trickleDown(index);
+            }
+            if (low == 0) {
+                return;
+            }
+            high = std::min(parent(high), low - 1);
+            low = parent(low);
+        }
+    }
+
+    // Small batches are cheapest as n single extractions. Once n * depth outgrows the heap, a single
+    // O(size) pass wins: select the n extremes with nth_element, sort just those, and rebuild the rest.
+    // Survivors keep their handles through the rebuild.
+    template <typename Before, typename ExtractOne>
+    std::vector<T> extractBatch(std::size_t n, Before before, ExtractOne extractOne) {
+        if (n > count) {
+            throw std::out_of_range("Heap holds fewer than the requested number of elements");
+        }
+        std::vector<T> result;
+        result.reserve(n);
+        if (n * (levelOf(count) + 1) < count) {
+            for (std::size_t i = 0; i < n; ++i) {
+                result.push_back(extractOne());
+            }
+            return result;
+        }
+        std::vector<std::pair<T, Handle>> entries;
+        entries.reserve(count);
+        for (std::size_t index = 0; index < count; ++index) {
+            std::size_t slot = Layout::physical(index);
+            entries.emplace_back(std::move(data[slot]), handleAt(slot));
+        }
+        auto split = entries.begin() + static_cast<std::ptrdiff_t>(n);
+        auto entryBefore = [&before](const std::pair<T, Handle>& a, const std::pair<T, Handle>& b) {
+            return before(a.first, b.first);
+        };
+        std::nth_element(entries.begin(), split, entries.end(), entryBefore);
+        std::sort(entries.begin(), split, entryBefore);
+        for (auto it = entries.begin(); it != split; ++it) {
+            result.push_back(std::move(it->first));
+            release(it->second);
+        }
+        count = 0;
+        for (auto it = split; it != entries.end(); ++it) {
+            place(std::move(it->first), it->second);
+        }
+        repairFrom(0);
+        return result;
+    }
+
+    void swapNodes(std::size_t a, std::size_t b) {
+        swapSlots(Layout::physical(a), Layout::physical(b));
+    }
+
+    // Every swap exchanges the two handles' positions too, which keeps the position index exact.
+    void swapSlots(std::size_t a, std::size_t b) {
+        using std::swap;
+        swap(data[a], data[b]);
+        if constexpr (TrackHandles) {
+            std::swap(positions[slotHandles[a]], positions[slotHandles[b]]);
+            std::swap(slotHandles[a], slotHandles[b]);
+        }
+    }
 
-    static size_t parent(size_t index) {
+    // Moves the element at logical index from into the hole at logical index to.
+    void moveNode(std::size_t from, std::size_t to) {
+        std::size_t fromSlot = Layout::physical(from);
+        std::size_t toSlot = Layout::physical(to);
+        data[toSlot] = std::move(data[fromSlot]);
+        if constexpr (TrackHandles) {
+            slotHandles[toSlot] = slotHandles[fromSlot];
+            positions[slotHandles[toSlot]] = static_cast<std::uint32_t>(to);
+        }
+    }
+
+    static std::size_t parent(std::size_t index) {
         return (index - 1) / 2;
     }
 
-    static size_t grandparent(size_t index) {
+    static std::size_t grandparent(std::size_t index) {
         return parent(parent(index));
     }
 
-    bool isMinLevel(size_t index) const {
-        // Compute the depth of the node; even depths obey min-heap ordering, odd depths obey max ordering.
-        size_t depth = 0;
-        while (index > 0) {
-            index = parent(index);
-            ++depth;
-        }
-        return depth % 2 == 0;
+    static bool isMinLevel(std::size_t index) {
+        // Even depths obey min-heap ordering, odd depths obey max ordering.
+        return levelOf(index) % 2 == 0;
     }
 
     // Bubble-up fixes ordering after insertions by moving a node toward the root until it satisfies
     // the min/max ordering for its level.
-    void bubbleUp(size_t index) {
+    void bubbleUp(std::size_t index) {
         if (index == 0) {
             return;
         }
-        size_t p = parent(index);
+        std::size_t p = parent(index);
         if (isMinLevel(index)) {
-            if (data[index] > data[p]) {
+            if (compare(at(p), at(index))) {
                 // Value is too large for a min level, so swap with parent and enforce max-level rules above.
-                std::swap(data[index], data[p]);
+                swapNodes(index, p);
                 bubbleUpMax(p);
             } else {
                 // Value respects the min-level constraint; move up through grandparent chain if needed.
                 bubbleUpMin(index);
             }
         } else {
-            if (data[index] < data[p]) {
+            if (compare(at(index), at(p))) {
                 // Value is too small for a max level; swap and propagate along the min-level ancestors.
-                std::swap(data[index], data[p]);
+                swapNodes(index, p);
                 bubbleUpMin(p);
             } else {
                 // Otherwise climb the max-level chain to position larger values nearer the top of that level.
@@ -127,33 +477,37 @@ private:
         }
     }
 
-    void bubbleUpMin(size_t index) {
+    // Both chain walks return the index where the value came to rest.
+    std::size_t bubbleUpMin(std::size_t index) {
         while (index >= 3) {
-            size_t gp = grandparent(index);
-            if (data[index] < data[gp]) {
+            std::size_t gp = grandparent(index);
+            if (compare(at(index), at(gp))) {
                 // Grandparent lives on the same min layer, so swap to move the small value upward.
-                std::swap(data[index], data[gp]);
+                swapNodes(index, gp);
                 index = gp;
             } else {
                 break;
             }
         }
+        return index;
     }
 
-    void bubbleUpMax(size_t index) {
+    std::size_t bubbleUpMax(std::size_t index) {
         while (index >= 3) {
-            size_t gp = grandparent(index);
-            if (data[index] > data[gp]) {
+            std::size_t gp = grandparent(index);
+            if (compare(at(gp), at(index))) {
                 // Promote larger values up the max layer by leapfrogging over the parent.
-                std::swap(data[index], data[gp]);
+                swapNodes(index, gp);
                 index = gp;
             } else {
                 break;
             }
         }
+        return index;
     }
 
-    void trickleDown(size_t index) {
+    void trickleDown(std::size_t index) {
+        DSA_COUNT("min_max_heap.trickle_down_calls", 1);
         if (isMinLevel(index)) {
             trickleDownMin(index);
         } else {
@@ -161,113 +515,559 @@ private:
         }
     }
 
-    // Trickle-down pushes a node downward until all descendants satisfy the ordering.
-    void trickleDownMin(size_t index) {
+    // Trickle-down pushes a node downward until all descendants satisfy the ordering. It tracks storage
+    // slots alongside logical indices so the loop never re-derives a slot it has already located.
+    void trickleDownMin(std::size_t index) {
+        std::size_t slot = Layout::physical(index);
         while (true) {
-            size_t m = minDescendant(index);
-            if (m == index) {
+            Descendant m = minDescendant(index, slot);
+            if (m.index == index) {
                 return;
             }
-            if (isGrandchild(index, m)) {
-                if (data[m] < data[index]) {
-                    std::swap(data[m], data[index]);
-                    size_t parentIdx = parent(m);
-                    if (data[m] > data[parentIdx]) {
+            if (isGrandchild(index, m.index)) {
+                if (compare(data[m.slot], data[slot])) {
+                    swapSlots(m.slot, slot);
+                    DSA_COUNT("min_max_heap.trickle_down_swaps", 1);
+                    if (compare(data[m.parentSlot], data[m.slot])) {
                         // After a grandchild swap, ensure the parent still dominates as a max-level node.
-                        std::swap(data[m], data[parentIdx]);
+                        swapSlots(m.slot, m.parentSlot);
+                        DSA_COUNT("min_max_heap.trickle_down_swaps", 1);
                     }
-                    index = m;
+                    index = m.index;
+                    slot = m.slot;
                 } else {
                     return;
                 }
             } else {
-                if (data[m] < data[index]) {
-                    std::swap(data[m], data[index]);
+                if (compare(data[m.slot], data[slot])) {
+                    swapSlots(m.slot, slot);
+                    DSA_COUNT("min_max_heap.trickle_down_swaps", 1);
                 }
                 return;
             }
         }
     }
 
-    void trickleDownMax(size_t index) {
+    void trickleDownMax(std::size_t index) {
+        std::size_t slot = Layout::physical(index);
         while (true) {
-            size_t m = maxDescendant(index);
-            if (m == index) {
+            Descendant m = maxDescendant(index, slot);
+            if (m.index == index) {
                 return;
             }
-            if (isGrandchild(index, m)) {
-                if (data[m] > data[index]) {
-                    std::swap(data[m], data[index]);
-                    size_t parentIdx = parent(m);
-                    if (data[m] < data[parentIdx]) {
+            if (isGrandchild(index, m.index)) {
+                if (compare(data[slot], data[m.slot])) {
+                    swapSlots(m.slot, slot);
+                    DSA_COUNT("min_max_heap.trickle_down_swaps", 1);
+                    if (compare(data[m.slot], data[m.parentSlot])) {
                         // After bubbling up a larger grandchild, fix any inversion with its direct parent.
-                        std::swap(data[m], data[parentIdx]);
+                        swapSlots(m.slot, m.parentSlot);
+                        DSA_COUNT("min_max_heap.trickle_down_swaps", 1);
                     }
-                    index = m;
+                    index = m.index;
+                    slot = m.slot;
                 } else {
                     return;
                 }
             } else {
-                if (data[m] > data[index]) {
-                    std::swap(data[m], data[index]);
+                if (compare(data[slot], data[m.slot])) {
+                    swapSlots(m.slot, slot);
+                    DSA_COUNT("min_max_heap.trickle_down_swaps", 1);
                 }
                 return;
             }
         }
     }
 
-    bool isGrandchild(size_t index, size_t descendant) const {
-        if (descendant == index) {
-            return false;
+    static bool isGrandchild(std::size_t index, std::size_t descendant) {
+        // Grandchildren occupy logical indices 4i+3 through 4i+6; children are 2i+1 and 2i+2.
+        return descendant >= 4 * index + 3;
+    }
+
+    // A candidate found by bestDescendant: its logical index, its storage slot, and its parent's slot
+    // (only meaningful for grandchildren, where trickle-down may need to fix the parent as well).
+    struct Descendant {
+        std::size_t index;
+        std::size_t slot;
+        std::size_t parentSlot;
+    };
+
+    // The candidates are the two children followed by the four grandchildren. They are not one contiguous
+    // index range (the children's siblings' subtrees sit in between), so each sibling group is located
+    // from the node's own slot and walked with Layout::groupOffset. Logical indices only bound the search.
+    // Trickle-down never changes level parity, so EvenDepth is fixed per caller and the layout arithmetic
+    // folds to constants.
+    template <bool EvenDepth, typename Better>
+    Descendant bestDescendant(std::size_t index, std::size_t slot, Better better) const {
+        std::size_t firstChild = 2 * index + 1;
+        if (firstChild >= count) {
+            return {index, slot, 0};
         }
-        size_t childStart = 2 * index + 1;
-        size_t childEnd = 2 * index + 2;
-        if (descendant >= data.size()) {
-            return false;
+        std::size_t childSlot = Layout::firstChildSlot(slot, EvenDepth);
+        Descendant best{firstChild, childSlot, 0};
+        if (firstChild + 1 < count) {
+            std::size_t sibling = childSlot + Layout::groupOffset(!EvenDepth, 1);
+            if (better(data[sibling], data[best.slot])) {
+                best = {firstChild + 1, sibling, 0};
+            }
         }
-        if (descendant == childStart || descendant == childEnd) {
-            return false;
+        std::size_t firstGrandchild = 4 * index + 3;
+        if (firstGrandchild >= count) {
+            return best;
         }
-        size_t p = parent(descendant);
-        // A node is a grandchild if its parent is one of the direct children of the starting index.
-        return p == childStart || p == childEnd;
+        std::size_t grandchildSlot = Layout::firstChildSlot(childSlot, !EvenDepth);
+        std::size_t grandchildren = std::min<std::size_t>(4, count - firstGrandchild);
+        for (std::size_t k = 0; k < grandchildren; ++k) {
+            std::size_t candidate = grandchildSlot + Layout::groupOffset(EvenDepth, k);
+            if (better(data[candidate], data[best.slot])) {
+                best = {firstGrandchild + k, candidate, childSlot + Layout::groupOffset(!EvenDepth, k / 2)};
+            }
+        }
+        return best;
+    }
+
+    Descendant minDescendant(std::size_t index, std::size_t slot) const {
+        // Examine children and grandchildren to find the smallest candidate under this min-level node.
+        return bestDescendant<true>(index, slot, [this](const T& a, const T& b) { return compare(a, b); });
     }
 
-    size_t minDescendant(size_t index) const {
-        size_t firstChild = 2 * index + 1;
-        if (firstChild >= data.size()) {
-            return index;
+    Descendant maxDescendant(std::size_t index, std::size_t slot) const {
+        // Symmetric to minDescendant: pick the largest among children and grandchildren of a max-level node.
+        return bestDescendant<false>(index, slot, [this](const T& a, const T& b) { return compare(b, a); });
+    }
+};
+
+// ConcurrentMinMaxQueue is a relaxed double-ended priority queue for many threads, built the MultiQueue
+// way (Rihani, Sanders, and Dementiev): several sequential min-max heaps, each behind its own mutex, with
+// a few heaps per thread. insert locks any one heap it can grab without waiting. An extraction samples two
+// heaps, compares their published extremes, and takes from the better one. Threads rarely meet on the
+// same lock, so throughput scales with cores; the price is that an extraction may return an element a
+// little away from the true minimum or maximum. runConcurrentBenchmark measures that rank error.
+//
+// Each heap publishes its size and extremes through atomics after every change so that sampling never
+// takes a lock. The snapshot can be stale by the time the lock is won, which is fine: choosing a heap is
+// only a heuristic, and the extraction itself happens under the lock. T must be trivially copyable
+// for std::atomic<T>, such as a priority or a priority packed together with a task id.
+template <typename T, typename Compare = std::less<T>>
+class ConcurrentMinMaxQueue {
+    static_assert(std::is_trivially_copyable<T>::value, "Published extremes require a trivially copyable T");
+
+public:
+    explicit ConcurrentMinMaxQueue(unsigned threads, unsigned heapsPerThread = 2, Compare comparator = Compare())
+        : compare(comparator), shardCount(std::max(1U, threads * heapsPerThread)), shards(new Shard[shardCount]) {
+        for (std::size_t i = 0; i < shardCount; ++i) {
+            shards[i].heap = ShardHeap(comparator);
         }
-        size_t minIdx = firstChild;
-        size_t lastDescendant = std::min(data.size() - 1, 2 * firstChild + 2);
-        for (size_t i = firstChild; i <= lastDescendant; ++i) {
-            if (data[i] < data[minIdx]) {
-                // Examine children and grandchildren to find the smallest candidate under this node.
-                minIdx = i;
+    }
+
+    void insert(T value) {
+        while (true) {
+            Shard& shard = shards[randomShard()];
+            std::unique_lock<std::mutex> guard(shard.lock, std::try_to_lock);
+            if (guard.owns_lock()) {
+                shard.heap.insert(value);
+                publish(shard);
+                return;
             }
         }
-        return minIdx;
     }
 
-    size_t maxDescendant(size_t index) const {
-        size_t firstChild = 2 * index + 1;
-        if (firstChild >= data.size()) {
-            return index;
+    // Both extractions return false only after a sweep over every heap found them all empty.
+    bool tryExtractMin(T& out) {
+        return tryExtract(out, true);
+    }
+
+    bool tryExtractMax(T& out) {
+        return tryExtract(out, false);
+    }
+
+    // Sum of the published sizes: exact once all threads are quiet, approximate while they are not.
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < shardCount; ++i) {
+            total += shards[i].size.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    using ShardHeap = MinMaxHeap<T, Compare, BinaryLayout, false>;
+
+    // One heap per cache line so that threads working on neighbouring heaps do not share lines.
+    struct alignas(64) Shard {
+        std::mutex lock;
+        ShardHeap heap;
+        std::atomic<std::size_t> size{0};
+        std::atomic<T> min{};
+        std::atomic<T> max{};
+    };
+
+    Compare compare;
+    std::size_t shardCount;
+    std::unique_ptr<Shard[]> shards;
+
+    static std::size_t randomIndex(std::size_t bound) {
+        thread_local std::minstd_rand rng(
+            static_cast<std::minstd_rand::result_type>(std::hash<std::thread::id>()(std::this_thread::get_id())));
+        return rng() % bound;
+    }
+
+    std::size_t randomShard() const {
+        return randomIndex(shardCount);
+    }
+
+    // Called with the shard's lock held after every change to its heap.
+    static void publish(Shard& shard) {
+        if (!shard.heap.empty()) {
+            shard.min.store(shard.heap.getMin(), std::memory_order_relaxed);
+            shard.max.store(shard.heap.getMax(), std::memory_order_relaxed);
+        }
+        shard.size.store(shard.heap.size(), std::memory_order_relaxed);
+    }
+
+    // Returns true if shard a's published extreme is the better pick for this end of the queue.
+    bool prefer(const Shard& a, const Shard& b, bool smallest) const {
+        if (smallest) {
+            return !compare(b.min.load(std::memory_order_relaxed), a.min.load(std::memory_order_relaxed));
+        }
+        return !compare(a.max.load(std::memory_order_relaxed), b.max.load(std::memory_order_relaxed));
+    }
+
+    bool tryExtract(T& out, bool smallest) {
+        for (std::size_t attempt = 0; attempt < 2 * shardCount; ++attempt) {
+            Shard* a = &shards[randomShard()];
+            Shard* b = &shards[randomShard()];
+            bool aHasItems = a->size.load(std::memory_order_relaxed) > 0;
+            bool bHasItems = b->size.load(std::memory_order_relaxed) > 0;
+            if (!aHasItems && !bHasItems) {
+                continue;
+            }
+            Shard* chosen = !bHasItems || (aHasItems && prefer(*a, *b, smallest)) ? a : b;
+            std::unique_lock<std::mutex> guard(chosen->lock, std::try_to_lock);
+            if (!guard.owns_lock() || chosen->heap.empty()) {
+                continue;
+            }
+            out = smallest ? chosen->heap.extractMin() : chosen->heap.extractMax();
+            publish(*chosen);
+            return true;
         }
-        size_t maxIdx = firstChild;
-        size_t lastDescendant = std::min(data.size() - 1, 2 * firstChild + 2);
-        for (size_t i = firstChild; i <= lastDescendant; ++i) {
-            if (data[i] > data[maxIdx]) {
-                // Symmetric to minDescendant: pick the largest among children and grandchildren.
-                maxIdx = i;
+        // Random sampling kept missing, which mostly happens when the queue is nearly empty. Sweep every
+        // heap with blocking locks before reporting that nothing is left.
+        for (std::size_t i = 0; i < shardCount; ++i) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            if (!shards[i].heap.empty()) {
+                out = smallest ? shards[i].heap.extractMin() : shards[i].heap.extractMax();
+                publish(shards[i]);
+                return true;
             }
         }
-        return maxIdx;
+        return false;
     }
 };
 
-int main() {
-    MinMaxHeap heap;
+// Fills a heap with random priorities and drains it from alternating ends, the access pattern of a
+// scheduler queue that serves both cheap (min) and urgent (max) work.
+template <typename Layout>
+void benchmarkLayout(const char* label, const std::vector<int>& values) {
+    MinMaxHeap<int, std::less<int>, Layout, false> heap;
+    auto start = std::chrono::steady_clock::now();
+    for (int value : values) {
+        heap.insert(value);
+    }
+    auto filled = std::chrono::steady_clock::now();
+    long long checksum = 0;
+    while (!heap.empty()) {
+        checksum += heap.extractMin();
+        if (!heap.empty()) {
+            checksum -= heap.extractMax();
+        }
+    }
+    auto drained = std::chrono::steady_clock::now();
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::cout << label << ": insert " << ms(start, filled) << " ms, drain " << ms(filled, drained)
+              << " ms (checksum " << checksum << ")\n";
+    bench::record(std::string(label) + " insert ms", ms(start, filled));
+    bench::record(std::string(label) + " drain ms", ms(filled, drained));
+}
+
+void runLayoutBenchmark() {
+    std::vector<int> values = bench::makeKeys(bench::Distribution::Uniform, std::size_t(1) << 22, 3);
+    std::cout << "Layout benchmark: " << values.size() << " random priorities\n";
+    benchmarkLayout<BinaryLayout>("BinaryLayout", values);
+    benchmarkLayout<BlockedLayout>("BlockedLayout", values);
+}
+
+// Reloads a scheduling epoch's worth of deadlines three ways (one insert per value, the bulk-build
+// constructor, and insertBatch on top of a half-full heap), then drains a quarter of them in one batch.
+void runBulkBenchmark() {
+    std::vector<int> values = bench::makeKeys(bench::Distribution::Uniform, std::size_t(1) << 22, 5);
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::cout << "Bulk benchmark: " << values.size() << " deadlines\n";
+    using DeadlineHeap = MinMaxHeap<int, std::less<int>, BinaryLayout, false>;
+
+    // Random input already bubbles up O(1) levels per insert on average. Deadlines generated in time
+    // order are the bad case: every new value is the largest so far and climbs the whole max chain.
+    std::vector<int> ascending = bench::makeKeys(bench::Distribution::Sorted, values.size());
+    for (const std::vector<int>* input : {&values, &ascending}) {
+        auto start = std::chrono::steady_clock::now();
+        DeadlineHeap repeated;
+        for (int value : *input) {
+            repeated.insert(value);
+        }
+        auto inserted = std::chrono::steady_clock::now();
+        DeadlineHeap built(input->begin(), input->end());
+        auto constructed = std::chrono::steady_clock::now();
+        std::string order = input == &values ? "random" : "ascending";
+        std::cout << order << ": repeated insert " << ms(start, inserted) << " ms, bulk build "
+                  << ms(inserted, constructed) << " ms\n";
+        bench::record(order + " repeated insert ms", ms(start, inserted));
+        bench::record(order + " bulk build ms", ms(inserted, constructed));
+    }
+
+    auto middle = values.begin() + static_cast<std::ptrdiff_t>(values.size() / 2);
+    DeadlineHeap oneByOne(values.begin(), middle);
+    DeadlineHeap batched(values.begin(), middle);
+    auto start = std::chrono::steady_clock::now();
+    for (auto it = middle; it != values.end(); ++it) {
+        oneByOne.insert(*it);
+    }
+    auto inserted = std::chrono::steady_clock::now();
+    batched.insertBatch(middle, values.end());
+    auto batchInserted = std::chrono::steady_clock::now();
+    std::cout << "second half: insert " << ms(start, inserted) << " ms, insertBatch " << ms(inserted, batchInserted)
+              << " ms\n";
+    bench::record("second half insert ms", ms(start, inserted));
+    bench::record("second half insertBatch ms", ms(inserted, batchInserted));
+
+    std::size_t drain = values.size() / 4;
+    long long checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < drain; ++i) {
+        checksum += oneByOne.extractMin();
+    }
+    auto extracted = std::chrono::steady_clock::now();
+    for (int value : batched.extractMinN(drain)) {
+        checksum -= value;
+    }
+    auto batchExtracted = std::chrono::steady_clock::now();
+    std::cout << "lowest quarter: extractMin " << ms(start, extracted) << " ms, extractMinN "
+              << ms(extracted, batchExtracted) << " ms (checksum " << checksum << ")\n";
+    bench::record("lowest quarter extractMin ms", ms(start, extracted));
+    bench::record("lowest quarter extractMinN ms", ms(extracted, batchExtracted));
+}
+
+// Reprioritizes tasks repeatedly and then drains them by deadline. The lazy baseline pushes a fresh
+// (priority, task) entry on every change and skips stale ones as they surface; the handle version
+// updates each task in place, so the heap never holds more than one entry per task.
+void runUpdateBenchmark() {
+    const std::size_t tasks = std::size_t(1) << 20;
+    const std::size_t updates = 4 * tasks;
+    bench::Rng rng(9);
+    std::vector<int> initial(tasks);
+    for (int& value : initial) {
+        value = static_cast<int>(rng.next() >> 33);
+    }
+    std::vector<std::pair<std::uint32_t, int>> changes(updates);
+    for (auto& change : changes) {
+        change = {static_cast<std::uint32_t>(rng.below(tasks)), static_cast<int>(rng.next() >> 33)};
+    }
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::cout << "Update benchmark: " << tasks << " tasks, " << updates << " priority changes\n";
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<int> current = initial;
+    MinMaxHeap<std::pair<int, std::uint32_t>, std::less<std::pair<int, std::uint32_t>>, BinaryLayout, false> lazy;
+    for (std::uint32_t task = 0; task < tasks; ++task) {
+        lazy.insert({initial[task], task});
+    }
+    for (const auto& change : changes) {
+        current[change.first] = change.second;
+        lazy.insert({change.second, change.first});
+    }
+    std::size_t peak = lazy.size();
+    long long checksum = 0;
+    while (!lazy.empty()) {
+        std::pair<int, std::uint32_t> entry = lazy.extractMin();
+        if (current[entry.second] == entry.first) {
+            // Mark the task as served so later duplicates with the same priority are skipped too.
+            current[entry.second] = -1;
+            checksum += entry.first;
+        }
+    }
+    auto lazyDone = std::chrono::steady_clock::now();
+
+    MinMaxHeap<> tracked(initial.begin(), initial.end());
+    for (const auto& change : changes) {
+        // The bulk constructor hands out handle k to the k-th value, so task ids double as handles.
+        tracked.update(change.first, change.second);
+    }
+    while (!tracked.empty()) {
+        checksum -= tracked.extractMin();
+    }
+    auto trackedDone = std::chrono::steady_clock::now();
+    std::cout << "lazy duplicates " << ms(start, lazyDone) << " ms (peak " << peak << " entries), handle update "
+              << ms(lazyDone, trackedDone) << " ms (peak " << tasks << " entries, checksum " << checksum << ")\n";
+    bench::record("lazy duplicates ms", ms(start, lazyDone));
+    bench::record("handle update ms", ms(lazyDone, trackedDone));
+}
+
+// Baseline for the concurrent benchmark: one sequential MinMaxHeap behind one mutex.
+class LockedMinMaxHeap {
+public:
+    void insert(int value) {
+        std::lock_guard<std::mutex> guard(lock);
+        heap.insert(value);
+    }
+
+    bool tryExtractMin(int& out) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (heap.empty()) {
+            return false;
+        }
+        out = heap.extractMin();
+        return true;
+    }
+
+    bool tryExtractMax(int& out) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (heap.empty()) {
+            return false;
+        }
+        out = heap.extractMax();
+        return true;
+    }
+
+private:
+    std::mutex lock;
+    MinMaxHeap<int, std::less<int>, BinaryLayout, false> heap;
+};
+
+// Runs a worker pool in which every thread inserts half the time and otherwise serves a cheap task
+// (extractMin) or an urgent one (extractMax), and returns the throughput in millions of operations per
+// second.
+template <typename Queue>
+double measureQueueThroughput(Queue& queue, unsigned threadCount, std::size_t opsPerThread) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&queue, t, opsPerThread]() {
+            bench::Rng rng(2000 + t);
+            int value = 0;
+            for (std::size_t op = 0; op < opsPerThread; ++op) {
+                std::uint64_t choice = rng.below(4);
+                if (choice < 2) {
+                    queue.insert(static_cast<int>(rng.next() >> 33));
+                } else if (choice == 2) {
+                    queue.tryExtractMin(value);
+                } else {
+                    queue.tryExtractMax(value);
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(threadCount * opsPerThread) / seconds / 1e6;
+}
+
+// Counts how many of the values 0..n-1 are still queued below a given value (a Fenwick tree), which
+// gives the exact rank of every element the relaxed queue hands out.
+class RankCounter {
+public:
+    explicit RankCounter(std::size_t n) : tree(n + 1, 0) {}
+
+    void add(std::size_t value, int delta) {
+        for (std::size_t i = value + 1; i < tree.size(); i += i & (~i + 1)) {
+            tree[i] += delta;
+        }
+    }
+
+    // Number of queued values strictly below value.
+    long long below(std::size_t value) const {
+        long long total = 0;
+        for (std::size_t i = value; i > 0; i -= i & (~i + 1)) {
+            total += tree[i];
+        }
+        return total;
+    }
+
+private:
+    std::vector<long long> tree;
+};
+
+// Rank error is measured on one thread so that "the current minimum" is well defined: the queue is
+// sized for threadCount workers, and each extraction is compared against the exact set of queued values.
+// A sequential MinMaxHeap always has rank error 0.
+void measureRankError(unsigned threadCount) {
+    const std::size_t n = std::size_t(1) << 18;
+    std::vector<int> values = bench::makeKeys(bench::Distribution::Sorted, n);
+    bench::Rng(13).shuffle(values);
+    ConcurrentMinMaxQueue<int> queue(threadCount);
+    RankCounter queued(n);
+    for (int value : values) {
+        queue.insert(value);
+        queued.add(static_cast<std::size_t>(value), 1);
+    }
+    long long remaining = static_cast<long long>(n);
+    double minErrorSum = 0;
+    double maxErrorSum = 0;
+    long long worstMin = 0;
+    long long worstMax = 0;
+    for (std::size_t round = 0; round < n / 2; ++round) {
+        int value = 0;
+        queue.tryExtractMin(value);
+        long long minError = queued.below(static_cast<std::size_t>(value));
+        queued.add(static_cast<std::size_t>(value), -1);
+        --remaining;
+        queue.tryExtractMax(value);
+        // Values above this one: everything queued that is neither below it nor the value itself.
+        long long maxError = remaining - 1 - queued.below(static_cast<std::size_t>(value));
+        queued.add(static_cast<std::size_t>(value), -1);
+        --remaining;
+        minErrorSum += static_cast<double>(minError);
+        maxErrorSum += static_cast<double>(maxError);
+        worstMin = std::max(worstMin, minError);
+        worstMax = std::max(worstMax, maxError);
+    }
+    double rounds = static_cast<double>(n / 2);
+    std::cout << "  rank error sized for " << threadCount << " threads: extractMin mean " << minErrorSum / rounds
+              << " (max " << worstMin << "), extractMax mean " << maxErrorSum / rounds << " (max " << worstMax
+              << ")\n";
+    std::string sizing = std::to_string(threadCount) + " threads";
+    bench::record("rank error " + sizing + " extractMin mean", minErrorSum / rounds);
+    bench::record("rank error " + sizing + " extractMax mean", maxErrorSum / rounds);
+}
+
+void runConcurrentBenchmark() {
+    const std::size_t opsPerThread = 500000;
+    std::cout << "Concurrent queue benchmark (Mops/s, " << std::thread::hardware_concurrency()
+              << " hardware threads): one locked heap vs ConcurrentMinMaxQueue\n";
+    for (unsigned threads : {1U, 2U, 4U, 8U}) {
+        // Both queues start with a standing backlog so extractions rarely find them empty.
+        LockedMinMaxHeap locked;
+        ConcurrentMinMaxQueue<int> relaxed(threads);
+        bench::Rng rng(17);
+        for (int i = 0; i < (1 << 20); ++i) {
+            int value = static_cast<int>(rng.next() >> 33);
+            locked.insert(value);
+            relaxed.insert(value);
+        }
+        double lockedRate = measureQueueThroughput(locked, threads, opsPerThread);
+        double relaxedRate = measureQueueThroughput(relaxed, threads, opsPerThread);
+        std::cout << "  " << threads << " threads: locked " << lockedRate << ", relaxed " << relaxedRate << "\n";
+        bench::record("locked " + std::to_string(threads) + " threads Mops/s", lockedRate);
+        bench::record("relaxed " + std::to_string(threads) + " threads Mops/s", relaxedRate);
+    }
+    for (unsigned threads : {1U, 4U, 16U}) {
+        measureRankError(threads);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    MinMaxHeap<> heap;
     heap.insert(10);
     heap.insert(5);
     heap.insert(30);
@@ -285,5 +1085,61 @@ int main() {
     std::cout << "Min after extractions: " << heap.getMin() << "\n";
     std::cout << "Max after extractions: " << heap.getMax() << "\n";
 
+    MinMaxHeap<int, std::less<int>, BlockedLayout> blockedHeap;
+    for (int value : {10, 5, 30, 3, 17, 22}) {
+        blockedHeap.insert(value);
+    }
+    // Only the memory layout differs, so the cache-blocked heap reports the same extremes.
+    std::cout << "Blocked layout min/max: " << blockedHeap.getMin() << " / " << blockedHeap.getMax() << "\n";
+
+    // Bulk construction heapifies the whole range at once; the batched calls work on several values per repair.
+    std::vector<int> deadlines = {42, 7, 19, 88, 3, 61, 25, 14, 70, 9};
+    MinMaxHeap<> epoch(deadlines.begin(), deadlines.end());
+    std::vector<int> extra = {1, 95, 50};
+    epoch.insertBatch(extra.begin(), extra.end());
+    std::cout << "Three earliest deadlines:";
+    for (int value : epoch.extractMinN(3)) {
+        std::cout << " " << value;
+    }
+    std::cout << "\nTwo latest deadlines:";
+    for (int value : epoch.extractMaxN(2)) {
+        std::cout << " " << value;
+    }
+    std::cout << "\n";
+
+    // Handles let a job's priority change in place instead of pushing a second copy of it.
+    MinMaxHeap<> jobs;
+    MinMaxHeap<>::Handle report = jobs.insert(40);
+    jobs.insert(25);
+    MinMaxHeap<>::Handle backup = jobs.insert(60);
+    jobs.update(report, 10);
+    std::cout << "After moving the report forward, min: " << jobs.getMin() << "\n";
+    jobs.erase(backup);
+    std::cout << "After cancelling the backup, max: " << jobs.getMax() << "\n";
+
+    // Four producers fill the shared queue at once; its size is exact again after they have joined.
+    ConcurrentMinMaxQueue<int> shared(4);
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([&shared, t]() {
+            for (int i = 0; i < 100; ++i) {
+                shared.insert(t * 100 + i);
+            }
+        });
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    std::cout << "Concurrent queue holds " << shared.size() << " tasks\n";
+
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("min_max_heap", argc, argv);
+        suite.run("layout", runLayoutBenchmark);
+        suite.run("bulk", runBulkBenchmark);
+        suite.run("update", runUpdateBenchmark);
+        suite.run("concurrent", runConcurrentBenchmark);
+        return suite.finish();
+    }
+
     return 0;
 }
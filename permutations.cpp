@@ -1,7 +1,18 @@
 #include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "bench_harness.h"
+#include "thread_slices.h"
+
 // This program generates all permutations of a sequence using backtracking.
 // Backtracking explores the search tree by choosing an element for the current position,
 // recursing on the remaining positions, and undoing the choice before trying the next option.
@@ -25,9 +36,189 @@ void generatePermutations(std::vector<int>& items, size_t index) {
     }
 }
 
-int main() {
+// Number of permutations of n distinct items, n!. Throws when it does not fit in 64 bits (n > 20).
+inline std::uint64_t permutationCount(std::size_t n) {
+    if (n > 20) {
+        throw std::overflow_error("n! does not fit in 64 bits for n > 20");
+    }
+    std::uint64_t count = 1;
+    for (std::size_t i = 2; i <= n; ++i) {
+        count *= i;
+    }
+    return count;
+}
+
+// Rearranges sorted, distinct items into the permutation with the given lexicographic rank. The rank is
+// read as a number in the factorial base: its leading digit (rank / (n-1)!) says which of the remaining
+// items comes first, and so on. Rotating the chosen item to the front keeps the rest sorted, so the
+// whole unranking works in place in O(n^2) without extra storage.
+inline void unrankPermutation(int* items, std::size_t n, std::uint64_t rank) {
+    if (rank >= permutationCount(n)) {
+        throw std::out_of_range("permutation rank past the last permutation");
+    }
+    for (std::size_t position = 0; position + 1 < n; ++position) {
+        std::uint64_t block = permutationCount(n - 1 - position);
+        std::size_t choice = position + static_cast<std::size_t>(rank / block);
+        rank %= block;
+        std::rotate(items + position, items + choice, items + choice + 1);
+    }
+}
+
+// Lazily enumerates a slice of the permutations of n distinct items, in lexicographic order, directly
+// inside the caller's buffer. The constructor sorts the buffer, jumps to permutation number `first`,
+// and each next() makes the buffer hold the following permutation: the first call leaves the starting
+// one, later calls step it with std::next_permutation (amortized O(1) swaps). Nothing is allocated,
+// so a search can consume permutations as fast as it can score them, and `first`/`count` let separate
+// threads walk disjoint slices of the n! space.
+class PermutationGenerator {
+public:
+    PermutationGenerator(int* buffer, std::size_t n, std::uint64_t first = 0,
+                         std::uint64_t count = std::numeric_limits<std::uint64_t>::max())
+        : items(buffer), size(n) {
+        std::sort(items, items + size);
+        if (std::adjacent_find(items, items + size) != items + size) {
+            throw std::invalid_argument("PermutationGenerator requires distinct items");
+        }
+        std::uint64_t total = permutationCount(size);
+        remaining = first < total ? std::min(count, total - first) : 0;
+        if (remaining != 0) {
+            unrankPermutation(items, size, first);
+        }
+    }
+
+    // Advances to the next permutation of the slice; returns false once the slice is exhausted.
+    bool next() {
+        if (remaining == 0) {
+            return false;
+        }
+        --remaining;
+        if (started) {
+            std::next_permutation(items, items + size);
+        }
+        started = true;
+        return true;
+    }
+
+    const int* current() const {
+        return items;
+    }
+
+private:
+    int* items;
+    std::size_t size;
+    std::uint64_t remaining;
+    bool started = false;
+};
+
+// Visits all permutations of items across threads. Each thread gets its own copy of the items as the
+// working buffer and a disjoint rank slice; visit(const int* permutation, unsigned thread) must be safe
+// to call concurrently. The items are checked here, before any thread starts, so bad input throws to
+// the caller instead of from every worker.
+template <typename Visitor>
+void forEachPermutationParallel(const std::vector<int>& items, unsigned threads, Visitor visit) {
+    std::uint64_t total = permutationCount(items.size());
+    std::vector<int> sorted = items;
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+        throw std::invalid_argument("forEachPermutationParallel requires distinct items");
+    }
+    forEachSlice(total, threads, [&](std::uint64_t first, std::uint64_t count, unsigned t) {
+        std::vector<int> buffer = items;
+        for (PermutationGenerator generator(buffer.data(), buffer.size(), first, count); generator.next();) {
+            visit(generator.current(), t);
+        }
+    });
+}
+
+// Scores every permutation of 11 items (39.9M) with a cheap position-weighted sum, comparing the lazy
+// generator on one thread, the same work split by unranking over several threads, and the recursive
+// swap-based enumeration turned into a visitor.
+void runPermutationBenchmark() {
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::vector<int> items(11);
+    std::iota(items.begin(), items.end(), 1);
+    auto score = [](const int* permutation, std::size_t n) {
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            sum += static_cast<std::uint64_t>(permutation[i]) * (i + 1);
+        }
+        return sum;
+    };
+    std::cout << "Permutation benchmark: " << permutationCount(items.size()) << " permutations of "
+              << items.size() << " items\n";
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t checksum = 0;
+    std::vector<int> buffer = items;
+    for (PermutationGenerator generator(buffer.data(), buffer.size()); generator.next();) {
+        checksum += score(generator.current(), buffer.size());
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "  PermutationGenerator " << ms(start, end) << " ms (checksum " << checksum << ")\n";
+    bench::record("generator ms", ms(start, end));
+
+    for (unsigned threads : {2u, 4u}) {
+        start = std::chrono::steady_clock::now();
+        std::vector<PaddedCounter> partial(threads);
+        forEachPermutationParallel(items, threads, [&](const int* permutation, unsigned t) {
+            partial[t].value += score(permutation, items.size());
+        });
+        end = std::chrono::steady_clock::now();
+        checksum = 0;
+        for (const PaddedCounter& sum : partial) {
+            checksum += sum.value;
+        }
+        std::cout << "  forEachPermutationParallel, " << threads << " threads " << ms(start, end) << " ms (checksum "
+                  << checksum << ")\n";
+        bench::record("parallel " + std::to_string(threads) + " threads ms", ms(start, end));
+    }
+
+    start = std::chrono::steady_clock::now();
+    checksum = 0;
+    buffer = items;
+    std::function<void(std::size_t)> recurse = [&](std::size_t index) {
+        if (index == buffer.size()) {
+            checksum += score(buffer.data(), buffer.size());
+            return;
+        }
+        for (std::size_t i = index; i < buffer.size(); ++i) {
+            std::swap(buffer[index], buffer[i]);
+            recurse(index + 1);
+            std::swap(buffer[index], buffer[i]);
+        }
+    };
+    recurse(0);
+    end = std::chrono::steady_clock::now();
+    std::cout << "  recursive backtracking " << ms(start, end) << " ms (checksum " << checksum << ")\n";
+    bench::record("recursive ms", ms(start, end));
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("permutations", argc, argv);
+        suite.run("permutations", runPermutationBenchmark);
+        return suite.finish();
+    }
+
     std::vector<int> values = {1, 2, 3};
     // Kick off the search with an empty prefix; recursion will explore the factorial search space.
     generatePermutations(values, 0);
+
+    // The lazy generator can start anywhere: permutations 2 through 4 (zero-based) of {1, 2, 3}.
+    int buffer[] = {3, 1, 2};
+    std::cout << "Permutations ranked 2..4:";
+    for (PermutationGenerator generator(buffer, 3, 2, 3); generator.next();) {
+        std::cout << " [" << generator.current()[0] << generator.current()[1] << generator.current()[2] << ']';
+    }
+    std::cout << "\n";
+
+    // Unranking alone answers "what is the millionth permutation of 0..9?" without enumerating.
+    int digits[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    unrankPermutation(digits, 10, 999999);
+    std::cout << "Permutation 999999 of 0..9: ";
+    for (int digit : digits) {
+        std::cout << digit;
+    }
+    std::cout << "\n";
     return 0;
 }
@@ -1,6 +1,16 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bench_harness.h"
 
 // This program implements a FIFO queue of integers backed by a circular buffer that grows
 // dynamically when full. Enqueue operations run in amortized constant time, while dequeue
@@ -87,7 +97,319 @@ private:
     std::size_t count = 0;
 };
 
-int main() {
+// Rounds a requested ring capacity up to a power of two (at least 2) so slot indices can be computed
+// with a mask instead of a division.
+inline std::size_t ringCapacity(std::size_t requested) {
+    std::size_t capacity = 2;
+    while (capacity < requested) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// Bounded single-producer/single-consumer ring. Exactly one thread may call tryPush and exactly one
+// (other) thread may call tryPop. Unlike Queue it never grows: a full ring makes tryPush return false
+// and the producer decides whether to spin, yield, or drop.
+//
+// head and tail are free-running counters (slot = counter & mask). Each lives on its own cache line
+// next to the owning side's cached copy of the other counter, so in the common case the producer only
+// touches its own line and the slot it writes: it re-reads the consumer's head only when its cached
+// copy says the ring is full, and the consumer re-reads tail only when its copy says it is empty.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t requestedCapacity)
+        : mask(ringCapacity(requestedCapacity) - 1), slots(mask + 1) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const {
+        return mask + 1;
+    }
+
+    // Producer only.
+    bool tryPush(T value) {
+        std::size_t position = tail.load(std::memory_order_relaxed);
+        if (position - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position - cachedHead > mask) {
+                return false;
+            }
+        }
+        slots[position & mask] = std::move(value);
+        // Release publishes the slot write to the consumer's acquire load of tail.
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only.
+    bool tryPop(T& out) {
+        std::size_t position = head.load(std::memory_order_relaxed);
+        if (position == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (position == cachedTail) {
+                return false;
+            }
+        }
+        out = std::move(slots[position & mask]);
+        // Release hands the emptied slot back to the producer.
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // Consumer-owned line.
+    alignas(64) std::atomic<std::size_t> head{0};
+    std::size_t cachedTail = 0;
+    // Producer-owned line.
+    alignas(64) std::atomic<std::size_t> tail{0};
+    std::size_t cachedHead = 0;
+    // Read-only after construction, shared by both sides.
+    alignas(64) const std::size_t mask;
+    std::vector<T> slots;
+};
+
+// Bounded multi-producer/multi-consumer queue after Dmitry Vyukov's design. Every slot carries a
+// sequence number that says whose turn it is: a slot at position p is free for the producer that
+// claims p when sequence == p, and holds a value for the consumer that claims p when
+// sequence == p + 1. Producers and consumers claim positions with a CAS on their own counter, so the
+// two sides never contend with each other, and a claimed slot is owned exclusively until its sequence
+// is advanced (to p + 1 after a push, p + capacity after a pop, the next lap's free state).
+template <typename T>
+class MpmcQueue {
+public:
+    explicit MpmcQueue(std::size_t requestedCapacity)
+        : mask(ringCapacity(requestedCapacity) - 1), cells(mask + 1) {
+        for (std::size_t i = 0; i <= mask; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    std::size_t capacity() const {
+        return mask + 1;
+    }
+
+    bool tryPush(T value) {
+        std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[position & mask];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto lag = static_cast<std::ptrdiff_t>(sequence - position);
+            if (lag == 0) {
+                // The slot is free on this lap; try to claim the position.
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                // The slot still holds last lap's value: the queue is full.
+                return false;
+            } else {
+                // Another producer claimed this position first.
+                DSA_COUNT("mpmc_queue.push_retries", 1);
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& out) {
+        std::size_t position = dequeuePosition.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[position & mask];
+            std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto lag = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+            if (lag == 0) {
+                if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                // No producer has filled this slot yet: the queue is empty.
+                return false;
+            } else {
+                DSA_COUNT("mpmc_queue.pop_retries", 1);
+                position = dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(cell->value);
+        cell->sequence.store(position + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    alignas(64) std::atomic<std::size_t> enqueuePosition{0};
+    alignas(64) std::atomic<std::size_t> dequeuePosition{0};
+    alignas(64) const std::size_t mask;
+    std::vector<Cell> cells;
+};
+
+// Baseline for the benchmark: the growable Queue above behind a mutex, bounded to the same capacity so
+// it is used the same way as the lock-free rings.
+class LockedQueue {
+public:
+    explicit LockedQueue(std::size_t requestedCapacity) : limit(requestedCapacity), queue(requestedCapacity) {}
+
+    bool tryPush(int value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.size() == limit) {
+            return false;
+        }
+        queue.enqueue(value);
+        return true;
+    }
+
+    bool tryPop(int& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.empty()) {
+            return false;
+        }
+        out = queue.dequeue();
+        return true;
+    }
+
+private:
+    std::size_t limit;
+    std::mutex mutex;
+    Queue queue;
+};
+
+// Spins on tryPush/tryPop, yielding between failed attempts so a waiting side gives up its core rather
+// than burning the time slice the other side needs when threads outnumber cores.
+template <typename Ring>
+void pushBlocking(Ring& ring, int value) {
+    while (!ring.tryPush(value)) {
+        std::this_thread::yield();
+    }
+}
+
+template <typename Ring>
+int popBlocking(Ring& ring) {
+    int value;
+    while (!ring.tryPop(value)) {
+        std::this_thread::yield();
+    }
+    return value;
+}
+
+// Moves itemsPerProducer * producers ints through the queue and returns millions of items per second.
+// The consumers check that every value arrived exactly once by comparing sums.
+template <typename Ring>
+double measureHandoff(std::size_t producers, std::size_t consumers, std::size_t itemsPerProducer) {
+    Ring ring(1 << 14);
+    const std::size_t total = producers * itemsPerProducer;
+    std::atomic<std::size_t> consumed{0};
+    std::atomic<long long> sum{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (std::size_t i = 0; i < itemsPerProducer; ++i) {
+                pushBlocking(ring, static_cast<int>(p * itemsPerProducer + i));
+            }
+        });
+    }
+    for (std::size_t c = 0; c < consumers; ++c) {
+        threads.emplace_back([&] {
+            long long local = 0;
+            int value;
+            // Consumers share the total through a counter so they know when everything is taken.
+            while (consumed.load(std::memory_order_relaxed) < total) {
+                if (ring.tryPop(value)) {
+                    local += value;
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            sum.fetch_add(local);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    long long expected = static_cast<long long>(total) * static_cast<long long>(total - 1) / 2;
+    if (sum.load() != expected) {
+        throw std::logic_error("Queue lost or duplicated items");
+    }
+    return static_cast<double>(total) / std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+// Bounces one value between two threads through a pair of queues and reports the median and 99th
+// percentile round-trip time in nanoseconds.
+template <typename Ring>
+std::pair<double, double> measureRoundTrip(std::size_t trips) {
+    Ring request(64);
+    Ring reply(64);
+    std::thread echo([&] {
+        for (std::size_t i = 0; i < trips; ++i) {
+            pushBlocking(reply, popBlocking(request));
+        }
+    });
+    std::vector<double> nanos(trips);
+    for (std::size_t i = 0; i < trips; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        pushBlocking(request, static_cast<int>(i));
+        popBlocking(reply);
+        nanos[i] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    echo.join();
+    std::sort(nanos.begin(), nanos.end());
+    return {nanos[trips / 2], nanos[trips * 99 / 100]};
+}
+
+void runQueueBenchmark() {
+    const std::size_t items = 1 << 23;
+    // Passes a measurement through to the output while recording it for the JSON report.
+    auto recorded = [](const std::string& metric, double value) {
+        bench::record(metric, value);
+        return value;
+    };
+    std::cout << "Queue handoff benchmark (M items/s, " << std::thread::hardware_concurrency()
+              << " hardware threads)\n";
+    std::cout << "  1 producer, 1 consumer: SpscRing "
+              << recorded("SpscRing 1x1 Mitems/s", measureHandoff<SpscRing<int>>(1, 1, items)) << ", MpmcQueue "
+              << recorded("MpmcQueue 1x1 Mitems/s", measureHandoff<MpmcQueue<int>>(1, 1, items)) << ", LockedQueue "
+              << recorded("LockedQueue 1x1 Mitems/s", measureHandoff<LockedQueue>(1, 1, items)) << "\n";
+    for (std::size_t threads : {2, 4}) {
+        std::string shape = " " + std::to_string(threads) + "x" + std::to_string(threads) + " Mitems/s";
+        std::cout << "  " << threads << " producers, " << threads << " consumers: MpmcQueue "
+                  << recorded("MpmcQueue" + shape, measureHandoff<MpmcQueue<int>>(threads, threads, items / threads))
+                  << ", LockedQueue "
+                  << recorded("LockedQueue" + shape, measureHandoff<LockedQueue>(threads, threads, items / threads))
+                  << "\n";
+    }
+    const std::size_t trips = 20000;
+    std::cout << "Queue round-trip latency over " << trips << " ping-pongs (ns, median / p99)\n";
+    auto report = [](const std::string& name, std::pair<double, double> latency) {
+        std::cout << "  " << name << " " << latency.first << " / " << latency.second << "\n";
+        bench::record(name + " round trip p50 ns", latency.first);
+        bench::record(name + " round trip p99 ns", latency.second);
+    };
+    report("SpscRing", measureRoundTrip<SpscRing<int>>(trips));
+    report("MpmcQueue", measureRoundTrip<MpmcQueue<int>>(trips));
+    report("LockedQueue", measureRoundTrip<LockedQueue>(trips));
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("queue", argc, argv);
+        suite.run("queue", runQueueBenchmark);
+        return suite.finish();
+    }
+
     Queue queue;
 
     for (int value : {5, 9, 13, 17}) {
@@ -109,5 +431,25 @@ int main() {
         std::cout << "Exception caught: " << ex.what() << "\n";
     }
 
+    // The bounded lock-free variants report a full or empty ring instead of growing or throwing.
+    SpscRing<int> ring(4);
+    int pushed = 0;
+    while (ring.tryPush(pushed)) {
+        ++pushed;
+    }
+    std::cout << "SpscRing of capacity " << ring.capacity() << " accepted " << pushed << " values\n";
+    MpmcQueue<int> shared(8);
+    std::thread producer([&] {
+        for (int value = 1; value <= 5; ++value) {
+            pushBlocking(shared, value * 100);
+        }
+    });
+    std::cout << "MpmcQueue handed over:";
+    for (int i = 0; i < 5; ++i) {
+        std::cout << ' ' << popBlocking(shared);
+    }
+    std::cout << "\n";
+    producer.join();
+
     return 0;
 }
@@ -1,16 +1,41 @@
+#include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <list>
+#include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include "bench_harness.h"
+#include "mapped_file.h"
 
 // This example implements a tiny recursive descent parser for arithmetic expressions.
 // Parsing relies on a grammar where expression -> term ((+|-) term)* and term -> factor ((*|/) factor)*.
 // Each non-terminal is mapped to a mutually recursive function. Because recursive descent follows the
 // grammar structure literally, it is a natural way to parse nested constructs such as parentheses.
+//
+// Parser evaluates while it parses, which is fine for a single answer but repeats all lexing and
+// parsing on every evaluation. Compiler walks the same grammar once and emits a Program: flat stack
+// bytecode that can be evaluated any number of times, with named variables read from an input row.
+// For large batches Program also runs column-at-a-time: every instruction sweeps a whole block of
+// rows before the next one starts, so dispatch is paid per block and the inner loops vectorize.
+// Before emitting code, Compiler folds constant subtrees and merges repeated sub-expressions so each
+// distinct computation runs once per evaluation; ProgramCache skips compilation for repeated texts.
 
 enum class TokenType {
     // Terminals in the grammar; End marks the sentinel once all input has been consumed.
     Number,
+    Identifier,
     Plus,
     Minus,
     Multiply,
@@ -22,39 +47,45 @@ enum class TokenType {
 
 struct Token {
     TokenType type;
-    double value; // Only meaningful when type == Number
+    double value;          // Only meaningful when type == Number
+    std::string_view name; // Only meaningful when type == Identifier; points into the lexer's input
 };
 
+// Lexer only views its input: nothing is copied, and tokens (including identifier names) refer back
+// into the caller's text, which therefore has to outlive the lexer and its tokens.
 class Lexer {
 public:
-    explicit Lexer(const std::string& input) : text(input), pos(0) {}
+    explicit Lexer(std::string_view input) : text(input), pos(0) {}
 
     Token nextToken() {
         // Skip over whitespace so tokens reflect only meaningful symbols from the grammar.
         skipWhitespace();
         if (pos >= text.size()) {
-            return {TokenType::End, 0.0};
+            return {TokenType::End, 0.0, {}};
         }
         char current = text[pos];
         if (std::isdigit(static_cast<unsigned char>(current)) || current == '.') {
             // Recognize integer and floating-point literals with the same helper.
             return numberToken();
         }
+        if (std::isalpha(static_cast<unsigned char>(current)) || current == '_') {
+            return identifierToken();
+        }
         ++pos;
         switch (current) {
-            case '+': return {TokenType::Plus, 0.0};
-            case '-': return {TokenType::Minus, 0.0};
-            case '*': return {TokenType::Multiply, 0.0};
-            case '/': return {TokenType::Divide, 0.0};
-            case '(': return {TokenType::LParen, 0.0};
-            case ')': return {TokenType::RParen, 0.0};
+            case '+': return {TokenType::Plus, 0.0, {}};
+            case '-': return {TokenType::Minus, 0.0, {}};
+            case '*': return {TokenType::Multiply, 0.0, {}};
+            case '/': return {TokenType::Divide, 0.0, {}};
+            case '(': return {TokenType::LParen, 0.0, {}};
+            case ')': return {TokenType::RParen, 0.0, {}};
             default:
                 throw std::runtime_error(std::string("Unexpected character: ") + current);
         }
     }
 
 private:
-    std::string text;
+    std::string_view text;
     size_t pos;
 
     void skipWhitespace() {
@@ -69,15 +100,32 @@ private:
         while (pos < text.size() && (std::isdigit(static_cast<unsigned char>(text[pos])) || text[pos] == '.')) {
             ++pos;
         }
-        // std::stod handles the fractional component and converts the substring to a numeric value.
-        double value = std::stod(text.substr(start, pos - start));
-        return {TokenType::Number, value};
+        // std::from_chars converts the digits in place: no substring, no locale lookup, and no exception
+        // on the success path, which makes it several times cheaper than std::stod on a temporary.
+        const char* first = text.data() + start;
+        const char* last = text.data() + pos;
+        double value = 0.0;
+        std::from_chars_result parsed = std::from_chars(first, last, value);
+        if (parsed.ec != std::errc() || parsed.ptr != last) {
+            throw std::runtime_error("Malformed number: " + std::string(first, last));
+        }
+        return {TokenType::Number, value, {}};
+    }
+
+    Token identifierToken() {
+        // Variable names follow the usual identifier rules: a letter or underscore, then alphanumerics.
+        size_t start = pos;
+        while (pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '_')) {
+            ++pos;
+        }
+        return {TokenType::Identifier, 0.0, text.substr(start, pos - start)};
     }
 };
 
 class Parser {
 public:
-    explicit Parser(Lexer lexer) : lexer(std::move(lexer)), currentToken(read()) {}
+    // Parser borrows the lexer and advances it in place rather than taking its own copy.
+    explicit Parser(Lexer& lexer) : lexer(lexer), currentToken(read()) {}
 
     double parseExpression() {
         // Entry point mirrors the grammar's start symbol (expression).
@@ -85,7 +133,7 @@ public:
     }
 
 private:
-    Lexer lexer;
+    Lexer& lexer;
     Token currentToken;
 
     Token read() {
@@ -154,21 +202,833 @@ private:
             consume(TokenType::RParen);
             return value;
         }
+        if (currentToken.type == TokenType::Identifier) {
+            throw std::runtime_error("Variable '" + std::string(currentToken.name) +
+                                     "' needs a compiled Program to evaluate");
+        }
         throw std::runtime_error("Expected number or parenthesis");
     }
 };
 
-int main() {
+// The instruction set of a stack machine: each instruction pops its operands from the top of the
+// evaluation stack and pushes its result.
+enum class OpCode : std::uint8_t {
+    PushConstant, // push constants[operand]
+    LoadVariable, // push row[operand]
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Negate,
+    StoreTemporary, // copy the top of the stack into temporaries[operand] without popping it
+    LoadTemporary   // push temporaries[operand]
+};
+
+struct Instruction {
+    OpCode op;
+    std::uint32_t operand; // Constant index, variable slot, or temporary; unused by arithmetic instructions.
+};
+
+// A compiled expression in postfix order. Variables are numbered by slot, and evaluate reads slot i
+// from row[i], so one Program runs against any number of input rows without being parsed again.
+// Temporaries hold the values of shared sub-expressions, which the optimizer computes once per
+// evaluation and then reloads wherever they reappear.
+class Program {
+public:
+    // Evaluates against one row of variable values laid out in variables() order.
+    double evaluate(const double* row) const {
+        // Straight-line bytecode needs at most maxDepth stack entries, which is known at compile time;
+        // the temporaries live in the same buffer just above the stack.
+        double inlineStack[kInlineStack];
+        std::vector<double> heapStack;
+        double* stack = inlineStack;
+        if (maxDepth + temporaryCount > kInlineStack) {
+            heapStack.resize(maxDepth + temporaryCount);
+            stack = heapStack.data();
+        }
+        double* temporaries = stack + maxDepth;
+        std::size_t top = 0;
+        for (const Instruction& instruction : code) {
+            switch (instruction.op) {
+                case OpCode::PushConstant: stack[top++] = constants[instruction.operand]; break;
+                case OpCode::LoadVariable: stack[top++] = row[instruction.operand]; break;
+                case OpCode::Add: --top; stack[top - 1] += stack[top]; break;
+                case OpCode::Subtract: --top; stack[top - 1] -= stack[top]; break;
+                case OpCode::Multiply: --top; stack[top - 1] *= stack[top]; break;
+                case OpCode::Divide:
+                    --top;
+                    if (stack[top] == 0.0) {
+                        throw std::runtime_error("Division by zero");
+                    }
+                    stack[top - 1] /= stack[top];
+                    break;
+                case OpCode::Negate: stack[top - 1] = -stack[top - 1]; break;
+                case OpCode::StoreTemporary: temporaries[instruction.operand] = stack[top - 1]; break;
+                case OpCode::LoadTemporary: stack[top++] = temporaries[instruction.operand]; break;
+            }
+        }
+        return stack[top - 1];
+    }
+
+    double evaluate(const std::vector<double>& row) const {
+        if (row.size() < variables.size()) {
+            throw std::invalid_argument("Row has fewer values than the program has variables");
+        }
+        return evaluate(row.data());
+    }
+
+    // Columnar batch evaluation: columns[i] holds rows values of variable slot i, and out receives
+    // one result per row. Rows are processed in blocks of kBlockRows; within a block the stack holds
+    // whole vectors, so each instruction becomes one tight loop over kBlockRows doubles instead of a
+    // switch per row. Variable loads push a pointer into the caller's column rather than copying it.
+    void evaluate(const std::vector<const double*>& columns, std::size_t rows, double* out) const {
+        if (columns.size() < variables.size()) {
+            throw std::invalid_argument("Fewer columns than the program has variables");
+        }
+        // One scratch block per stack level; level k's result is written into scratch block k. The
+        // temporaries' blocks follow the stack's.
+        std::vector<double> scratch(std::max<std::size_t>(maxDepth + temporaryCount, 1) * kBlockRows);
+        double* temporaries = scratch.data() + maxDepth * kBlockRows;
+        std::vector<const double*> stack(maxDepth);
+        for (std::size_t first = 0; first < rows; first += kBlockRows) {
+            const std::size_t n = std::min(kBlockRows, rows - first);
+            std::size_t top = 0;
+            for (const Instruction& instruction : code) {
+                switch (instruction.op) {
+                    case OpCode::PushConstant: {
+                        double* slot = scratch.data() + top * kBlockRows;
+                        std::fill(slot, slot + n, constants[instruction.operand]);
+                        stack[top++] = slot;
+                        break;
+                    }
+                    case OpCode::LoadVariable:
+                        stack[top++] = columns[instruction.operand] + first;
+                        break;
+                    case OpCode::StoreTemporary: {
+                        double* slot = temporaries + instruction.operand * kBlockRows;
+                        std::copy(stack[top - 1], stack[top - 1] + n, slot);
+                        break;
+                    }
+                    case OpCode::LoadTemporary:
+                        stack[top++] = temporaries + instruction.operand * kBlockRows;
+                        break;
+                    case OpCode::Negate: {
+                        const double* a = stack[top - 1];
+                        double* result = scratch.data() + (top - 1) * kBlockRows;
+                        for (std::size_t i = 0; i < n; ++i) {
+                            result[i] = -a[i];
+                        }
+                        stack[top - 1] = result;
+                        break;
+                    }
+                    default: {
+                        --top;
+                        double* result = scratch.data() + (top - 1) * kBlockRows;
+                        const double* a = stack[top - 1];
+                        const double* b = stack[top];
+                        applyBinary(instruction.op, a, b, result, n);
+                        stack[top - 1] = result;
+                        break;
+                    }
+                }
+            }
+            std::copy(stack[0], stack[0] + n, out + first);
+        }
+    }
+
+    // Convenience overload for owned columns; every column must have the same length.
+    std::vector<double> evaluate(const std::vector<std::vector<double>>& columns) const {
+        std::size_t rows = columns.empty() ? 0 : columns.front().size();
+        std::vector<const double*> views;
+        views.reserve(columns.size());
+        for (const std::vector<double>& column : columns) {
+            if (column.size() != rows) {
+                throw std::invalid_argument("Columns must all have the same number of rows");
+            }
+            views.push_back(column.data());
+        }
+        if (views.size() < variables.size()) {
+            throw std::invalid_argument("Fewer columns than the program has variables");
+        }
+        // A program without variables still yields one value per row; with no columns that is one row.
+        if (variables.empty() && columns.empty()) {
+            rows = 1;
+        }
+        std::vector<double> out(rows);
+        evaluate(views, rows, out.data());
+        return out;
+    }
+
+    const std::vector<std::string>& variableNames() const {
+        return variables;
+    }
+
+    std::size_t instructionCount() const {
+        return code.size();
+    }
+
+    std::size_t temporaries() const {
+        return temporaryCount;
+    }
+
+private:
+    friend class Compiler;
+
+    static constexpr std::size_t kInlineStack = 32;
+    // 512 doubles per stack level keeps a typical program's working set inside L1/L2.
+    static constexpr std::size_t kBlockRows = 512;
+
+    // The arithmetic kernels of the columnar path. Each loop has no cross-iteration dependency, so
+    // the compiler turns it into SIMD code; division scans its divisors first so the error matches the
+    // row-at-a-time evaluator without a branch inside the hot loop.
+    static void applyBinary(OpCode op, const double* a, const double* b, double* result, std::size_t n) {
+        switch (op) {
+            case OpCode::Add:
+                for (std::size_t i = 0; i < n; ++i) {
+                    result[i] = a[i] + b[i];
+                }
+                break;
+            case OpCode::Subtract:
+                for (std::size_t i = 0; i < n; ++i) {
+                    result[i] = a[i] - b[i];
+                }
+                break;
+            case OpCode::Multiply:
+                for (std::size_t i = 0; i < n; ++i) {
+                    result[i] = a[i] * b[i];
+                }
+                break;
+            case OpCode::Divide: {
+                bool zero = false;
+                for (std::size_t i = 0; i < n; ++i) {
+                    zero |= b[i] == 0.0;
+                }
+                if (zero) {
+                    throw std::runtime_error("Division by zero");
+                }
+                for (std::size_t i = 0; i < n; ++i) {
+                    result[i] = a[i] / b[i];
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    std::vector<Instruction> code;
+    std::vector<double> constants;
+    std::vector<std::string> variables;
+    std::size_t maxDepth = 0;
+    std::size_t temporaryCount = 0;
+};
+
+// Compiler parses the same grammar as Parser, but each rule builds a node of an expression DAG instead
+// of computing a value; code generation then walks the DAG and emits postfix bytecode, so operands are
+// always on the stack before the operator that consumes them.
+//
+// With optimize set (the default), two rewrites happen while the DAG is built:
+//   - Constant folding: an operator whose operands are all constants is evaluated at compile time
+//     with the same double arithmetic the Program would use, so results are bit-for-bit unchanged.
+//     A constant division by zero is left in place so it still fails at evaluation, like Parser.
+//     Nothing is reassociated: x + 1 + 2 is (x + 1) + 2, and regrouping it would change rounding.
+//   - Hash-consing: every node is interned by (operator, operands), so identical sub-expressions
+//     become one shared node. + and * are commutative in IEEE arithmetic, so their operands are put
+//     in a canonical order first and x * y shares a node with y * x.
+// Code generation computes a shared operator node once per evaluation, keeps its value in a temporary,
+// and reloads the temporary at every later use.
+class Compiler {
+public:
+    // variables fixes the slot order of known inputs (for example the columns of a table); any other
+    // name found in the expression is given the next free slot.
+    explicit Compiler(Lexer& lexer, std::vector<std::string> variables = {}, bool optimize = true)
+        : lexer(lexer), currentToken(read()), optimize(optimize) {
+        program.variables = std::move(variables);
+    }
+
+    Program compile() {
+        std::uint32_t root = expression();
+        if (currentToken.type != TokenType::End) {
+            throw std::runtime_error("Unexpected token after expression");
+        }
+        uses.assign(nodes.size(), 0);
+        countUses(root);
+        temporaries.assign(nodes.size(), kNoTemporary);
+        generate(root);
+        return std::move(program);
+    }
+
+private:
+    // One vertex of the expression DAG. payload is the bit pattern of a constant or the slot of a
+    // variable; operators refer to their operands by node index (right is unused by Negate).
+    struct Node {
+        OpCode op;
+        std::uint64_t payload;
+        std::uint32_t left;
+        std::uint32_t right;
+
+        bool operator==(const Node& other) const {
+            return op == other.op && payload == other.payload && left == other.left && right == other.right;
+        }
+    };
+
+    struct NodeHash {
+        std::size_t operator()(const Node& node) const {
+            std::uint64_t h = node.payload * 0x9E3779B97F4A7C15ULL;
+            std::uint64_t children = static_cast<std::uint64_t>(node.left) << 32 | node.right;
+            h ^= children + 0x632BE59BD9B4E019ULL + (h << 6) + (h >> 2);
+            return static_cast<std::size_t>(h ^ static_cast<std::uint64_t>(node.op));
+        }
+    };
+
+    static constexpr std::uint32_t kNoTemporary = UINT32_MAX;
+    // Work-stack entries of the two DAG walks that fit on the call stack before they move to the heap.
+    static constexpr std::size_t kInlinePending = 128;
+
+    // An entry of generate()'s work stack; operandsEmitted marks the second visit to an operator.
+    struct Visit {
+        std::uint32_t index;
+        bool operandsEmitted;
+    };
+
+    Lexer& lexer;
+    Token currentToken;
+    bool optimize;
+    Program program;
+    std::size_t depth = 0;
+    std::vector<Node> nodes;
+    std::unordered_map<Node, std::uint32_t, NodeHash> interned;
+    std::unordered_map<std::uint64_t, std::uint32_t> constantSlots; // constant bits -> constants index
+    std::vector<std::uint32_t> uses;
+    std::vector<std::uint32_t> temporaries;
+
+    Token read() {
+        return lexer.nextToken();
+    }
+
+    void consume(TokenType expected) {
+        if (currentToken.type != expected) {
+            throw std::runtime_error("Unexpected token");
+        }
+        currentToken = read();
+    }
+
+    static std::uint64_t bitsOf(double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        return bits;
+    }
+
+    static double valueOf(std::uint64_t bits) {
+        double value;
+        std::memcpy(&value, &bits, sizeof value);
+        return value;
+    }
+
+    std::uint32_t intern(const Node& node) {
+        if (optimize) {
+            auto found = interned.find(node);
+            if (found != interned.end()) {
+                return found->second;
+            }
+        }
+        nodes.push_back(node);
+        std::uint32_t index = static_cast<std::uint32_t>(nodes.size() - 1);
+        if (optimize) {
+            interned.emplace(node, index);
+        }
+        return index;
+    }
+
+    std::uint32_t constant(double value) {
+        return intern({OpCode::PushConstant, bitsOf(value), 0, 0});
+    }
+
+    bool isConstant(std::uint32_t index) const {
+        return nodes[index].op == OpCode::PushConstant;
+    }
+
+    std::uint32_t negate(std::uint32_t operand) {
+        if (optimize && isConstant(operand)) {
+            return constant(-valueOf(nodes[operand].payload));
+        }
+        return intern({OpCode::Negate, 0, operand, 0});
+    }
+
+    std::uint32_t binary(OpCode op, std::uint32_t left, std::uint32_t right) {
+        if (optimize && isConstant(left) && isConstant(right)) {
+            double a = valueOf(nodes[left].payload);
+            double b = valueOf(nodes[right].payload);
+            switch (op) {
+                case OpCode::Add: return constant(a + b);
+                case OpCode::Subtract: return constant(a - b);
+                case OpCode::Multiply: return constant(a * b);
+                case OpCode::Divide:
+                    if (b != 0.0) {
+                        return constant(a / b);
+                    }
+                    break;
+                default: break;
+            }
+        }
+        if (optimize && (op == OpCode::Add || op == OpCode::Multiply) && left > right) {
+            std::swap(left, right);
+        }
+        return intern({op, 0, left, right});
+    }
+
+    // A node's use count is the number of distinct DAG edges into it; a shared node's own operands
+    // are counted once, because its value is computed once. Both DAG walks keep an explicit stack:
+    // expression() builds a flat chain such as x + x + ... + x iteratively, and the chain is as deep as
+    // it has terms, far deeper than the call stack could follow. As in Program::evaluate, the stack's
+    // bound is known before the walk starts, so a typical formula's stack lives in an inline array.
+    void countUses(std::uint32_t root) {
+        // Each node pushes its operands at most once, so at most 2 * nodes + 1 entries are ever pushed.
+        std::uint32_t inlinePending[kInlinePending];
+        std::vector<std::uint32_t> heapPending;
+        std::uint32_t* pending = inlinePending;
+        if (2 * nodes.size() + 1 > kInlinePending) {
+            heapPending.resize(2 * nodes.size() + 1);
+            pending = heapPending.data();
+        }
+        std::size_t top = 0;
+        pending[top++] = root;
+        while (top > 0) {
+            std::uint32_t index = pending[--top];
+            if (uses[index]++ > 0) {
+                continue;
+            }
+            const Node& node = nodes[index];
+            if (node.op == OpCode::Negate) {
+                pending[top++] = node.left;
+            } else if (node.op != OpCode::PushConstant && node.op != OpCode::LoadVariable) {
+                pending[top++] = node.right;
+                pending[top++] = node.left;
+            }
+        }
+    }
+
+    // Emits operands left to right, then the operator. An operator node is popped once to push its
+    // operands above a marker for itself, and the marker is popped after they have been emitted. The
+    // left operand is finished before the right one is looked at, so a temporary stored on the left is
+    // already there for the right.
+    void generate(std::uint32_t root) {
+        // Every node is expanded at most once (a shared one is reloaded afterwards): one marker and up
+        // to two operands each, at most 3 * nodes + 1 entries.
+        Visit inlinePending[kInlinePending];
+        std::vector<Visit> heapPending;
+        Visit* pending = inlinePending;
+        if (3 * nodes.size() + 1 > kInlinePending) {
+            heapPending.resize(3 * nodes.size() + 1);
+            pending = heapPending.data();
+        }
+        std::size_t top = 0;
+        pending[top++] = {root, false};
+        while (top > 0) {
+            Visit visit = pending[--top];
+            std::uint32_t index = visit.index;
+            const Node& node = nodes[index];
+            if (visit.operandsEmitted) {
+                emit(node.op);
+                if (uses[index] > 1) {
+                    temporaries[index] = static_cast<std::uint32_t>(program.temporaryCount++);
+                    emit(OpCode::StoreTemporary, temporaries[index]);
+                }
+                continue;
+            }
+            if (temporaries[index] != kNoTemporary) {
+                emit(OpCode::LoadTemporary, temporaries[index]);
+                continue;
+            }
+            switch (node.op) {
+                case OpCode::PushConstant:
+                    // Leaves are as cheap to reload as a temporary, so they are never stored.
+                    emit(OpCode::PushConstant, constantSlot(node.payload));
+                    break;
+                case OpCode::LoadVariable:
+                    emit(OpCode::LoadVariable, static_cast<std::uint32_t>(node.payload));
+                    break;
+                case OpCode::Negate:
+                    pending[top++] = {index, true};
+                    pending[top++] = {node.left, false};
+                    break;
+                default:
+                    pending[top++] = {index, true};
+                    pending[top++] = {node.right, false};
+                    pending[top++] = {node.left, false};
+                    break;
+            }
+        }
+    }
+
+    std::uint32_t constantSlot(std::uint64_t bits) {
+        auto found = constantSlots.find(bits);
+        if (found != constantSlots.end()) {
+            return found->second;
+        }
+        program.constants.push_back(valueOf(bits));
+        std::uint32_t slot = static_cast<std::uint32_t>(program.constants.size() - 1);
+        constantSlots.emplace(bits, slot);
+        return slot;
+    }
+
+    // Tracks the stack height the emitted code reaches so Program can size its stack up front.
+    void emit(OpCode op, std::uint32_t operand = 0) {
+        program.code.push_back({op, operand});
+        if (op == OpCode::PushConstant || op == OpCode::LoadVariable || op == OpCode::LoadTemporary) {
+            ++depth;
+            program.maxDepth = std::max(program.maxDepth, depth);
+        } else if (op != OpCode::Negate && op != OpCode::StoreTemporary) {
+            --depth;
+        }
+    }
+
+    std::uint32_t slotOf(std::string_view name) {
+        for (std::size_t slot = 0; slot < program.variables.size(); ++slot) {
+            if (program.variables[slot] == name) {
+                return static_cast<std::uint32_t>(slot);
+            }
+        }
+        program.variables.emplace_back(name);
+        return static_cast<std::uint32_t>(program.variables.size() - 1);
+    }
+
+    std::uint32_t expression() {
+        // expression := term ((+|-) term)*
+        std::uint32_t node = term();
+        while (currentToken.type == TokenType::Plus || currentToken.type == TokenType::Minus) {
+            TokenType op = currentToken.type;
+            consume(op);
+            std::uint32_t right = term();
+            node = binary(op == TokenType::Plus ? OpCode::Add : OpCode::Subtract, node, right);
+        }
+        return node;
+    }
+
+    std::uint32_t term() {
+        // term := factor ((*|/) factor)*
+        std::uint32_t node = factor();
+        while (currentToken.type == TokenType::Multiply || currentToken.type == TokenType::Divide) {
+            TokenType op = currentToken.type;
+            consume(op);
+            std::uint32_t right = factor();
+            node = binary(op == TokenType::Multiply ? OpCode::Multiply : OpCode::Divide, node, right);
+        }
+        return node;
+    }
+
+    std::uint32_t factor() {
+        if (currentToken.type == TokenType::Number) {
+            std::uint32_t node = constant(currentToken.value);
+            consume(TokenType::Number);
+            return node;
+        }
+        if (currentToken.type == TokenType::Identifier) {
+            std::uint32_t node = intern({OpCode::LoadVariable, slotOf(currentToken.name), 0, 0});
+            consume(TokenType::Identifier);
+            return node;
+        }
+        if (currentToken.type == TokenType::Minus) {
+            consume(TokenType::Minus);
+            return negate(factor());
+        }
+        if (currentToken.type == TokenType::LParen) {
+            consume(TokenType::LParen);
+            std::uint32_t node = expression();
+            consume(TokenType::RParen);
+            return node;
+        }
+        throw std::runtime_error("Expected number, variable, or parenthesis");
+    }
+};
+
+// Compiles text once; the returned Program can be evaluated repeatedly.
+Program compileExpression(std::string_view text, std::vector<std::string> variables = {}, bool optimize = true) {
+    Lexer lexer(text);
+    return Compiler(lexer, std::move(variables), optimize).compile();
+}
+
+// LRU cache from expression text to compiled Program, for callers that see the same formulas
+// submitted over and over: a hit skips lexing, parsing, and optimization entirely. Programs are handed
+// out as shared_ptr so a caller can keep evaluating one even after the cache has evicted it.
+class ProgramCache {
+public:
+    // Every program in the cache is compiled against the same variable layout.
+    explicit ProgramCache(std::size_t capacity, std::vector<std::string> variables = {})
+        : capacity(std::max<std::size_t>(capacity, 1)), variables(std::move(variables)) {}
+
+    std::shared_ptr<const Program> get(std::string_view text) {
+        auto found = index.find(text);
+        if (found != index.end()) {
+            ++hitCount;
+            // The list runs from most to least recently used; splice moves the entry without copying.
+            entries.splice(entries.begin(), entries, found->second);
+            return found->second->second;
+        }
+        ++missCount;
+        // Text that fails to compile throws here and is not cached.
+        auto program = std::make_shared<const Program>(compileExpression(text, variables));
+        entries.emplace_front(std::string(text), program);
+        // The key views the string stored in the list node, which stays put for the entry's lifetime.
+        index.emplace(entries.front().first, entries.begin());
+        if (entries.size() > capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+        return program;
+    }
+
+    std::size_t size() const {
+        return entries.size();
+    }
+
+    std::size_t hits() const {
+        return hitCount;
+    }
+
+    std::size_t misses() const {
+        return missCount;
+    }
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const Program>>;
+
+    std::size_t capacity;
+    std::vector<std::string> variables;
+    std::list<Entry> entries;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+    std::size_t hitCount = 0;
+    std::size_t missCount = 0;
+};
+
+// Streaming mode: walks one large buffer of newline-separated expressions (a file read or mapped into
+// memory) and hands out each line as a view into the buffer, so a batch of a million expressions is
+// lexed and parsed without a single per-line allocation. Blank lines are skipped and a trailing '\r'
+// is dropped so files with Windows line endings work as well.
+class ExpressionStream {
+public:
+    explicit ExpressionStream(std::string_view buffer) : rest(buffer) {}
+
+    // Stores the next non-blank line in line and returns true, or returns false once the buffer is used up.
+    bool next(std::string_view& line) {
+        while (!rest.empty()) {
+            // string_view::find on a single character compiles down to memchr.
+            std::size_t newline = rest.find('\n');
+            line = rest.substr(0, newline);
+            rest = newline == std::string_view::npos ? std::string_view() : rest.substr(newline + 1);
+            ++lines;
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (line.find_first_not_of(" \t\v\f") != std::string_view::npos) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 1-based number of the line last returned by next, for error messages.
+    std::size_t lineNumber() const {
+        return lines;
+    }
+
+private:
+    std::string_view rest;
+    std::size_t lines = 0;
+};
+
+#if defined(DSA_HAVE_MMAP)
+// Read-only memory map of a text file, exposed as one string_view for ExpressionStream. The kernel
+// pages the file in as the stream walks through it, so even files larger than memory need no buffer.
+class MappedText {
+public:
+    explicit MappedText(const std::string& path) : file(path, "expression file") {}
+
+    std::string_view view() const {
+        return std::string_view(file.data(), file.size());
+    }
+
+private:
+    MappedFile file;
+};
+#endif
+
+// Evaluates one formula over many rows in three ways: re-parsing the text for every row, evaluating a
+// compiled Program row by row, and evaluating it once over whole columns. Parser has no variables, so
+// the re-parse path splices each row's values in as literals and streams the texts from one buffer.
+void runCompileBenchmark() {
+    const std::size_t rows = 1 << 20;
+    const std::string formula = "(x + 2.5) * (y - 1) / 3 + x * x - 4 * (y + 0.5)";
+    std::vector<double> table(2 * rows);
+    bench::Rng rng(23);
+    for (double& value : table) {
+        value = rng.between(1.0, 100.0);
+    }
+    // All the spliced texts go into one newline-separated buffer, the same shape as an expression file.
+    std::ostringstream text;
+    text.precision(17);
+    for (std::size_t r = 0; r < rows; ++r) {
+        double x = table[2 * r];
+        double y = table[2 * r + 1];
+        text << "(" << x << " + 2.5) * (" << y << " - 1) / 3 + " << x << " * " << x << " - 4 * (" << y << " + 0.5)\n";
+    }
+    const std::string batch = text.str();
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+
+    auto start = std::chrono::steady_clock::now();
+    double parsedSum = 0;
+    ExpressionStream stream(batch);
+    for (std::string_view line; stream.next(line);) {
+        Lexer lexer(line);
+        Parser parser(lexer);
+        parsedSum += parser.parseExpression();
+    }
+    auto parsed = std::chrono::steady_clock::now();
+    Program program = compileExpression(formula, {"x", "y"});
+    double compiledSum = 0;
+    for (std::size_t r = 0; r < rows; ++r) {
+        compiledSum += program.evaluate(&table[2 * r]);
+    }
+    auto compiled = std::chrono::steady_clock::now();
+    // The columnar path wants one contiguous array per variable rather than interleaved rows.
+    std::vector<double> xs(rows);
+    std::vector<double> ys(rows);
+    for (std::size_t r = 0; r < rows; ++r) {
+        xs[r] = table[2 * r];
+        ys[r] = table[2 * r + 1];
+    }
+    std::vector<double> results(rows);
+    auto columnarStart = std::chrono::steady_clock::now();
+    program.evaluate({xs.data(), ys.data()}, rows, results.data());
+    auto columnar = std::chrono::steady_clock::now();
+    double columnarSum = 0;
+    for (double value : results) {
+        columnarSum += value;
+    }
+    std::cout << "Compile benchmark: " << rows << " rows of \"" << formula << "\"\n"
+              << "  parse per row " << ms(start, parsed) << " ms, compiled per row " << ms(parsed, compiled)
+              << " ms, compiled columnar " << ms(columnarStart, columnar) << " ms (" << program.instructionCount()
+              << " instructions; sums " << parsedSum << " / " << compiledSum << " / " << columnarSum << ")\n";
+    bench::record("parse per row ns/row", ms(start, parsed) * 1e6 / rows);
+    bench::record("compiled per row ns/row", ms(parsed, compiled) * 1e6 / rows);
+    bench::record("compiled columnar ns/row", ms(columnarStart, columnar) * 1e6 / rows);
+}
+
+// Measures the optimizer on a formula with a constant subtree and repeated sub-expressions, then the
+// program cache on a stream of submissions drawn from a small set of distinct formulas.
+void runOptimizerBenchmark() {
+    const std::size_t rows = 1 << 20;
+    const std::string formula =
+        "(x * y + 3) * (x * y + 3) - (2 * 3.5 - 1) * x / (x * y + 3) + (y - x) * (x - y) * (1 + 2 + 3) / (4 * 0.5)";
+    std::vector<std::vector<double>> columns(2, std::vector<double>(rows));
+    bench::Rng rng(29);
+    for (std::vector<double>& column : columns) {
+        for (double& value : column) {
+            value = rng.between(1.0, 100.0);
+        }
+    }
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+
+    Program plain = compileExpression(formula, {"x", "y"}, false);
+    Program optimized = compileExpression(formula, {"x", "y"});
+    auto start = std::chrono::steady_clock::now();
+    std::vector<double> plainResults = plain.evaluate(columns);
+    auto middle = std::chrono::steady_clock::now();
+    std::vector<double> optimizedResults = optimized.evaluate(columns);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "Optimizer benchmark: " << rows << " rows of \"" << formula << "\"\n"
+              << "  unoptimized " << plain.instructionCount() << " instructions, " << ms(start, middle)
+              << " ms; optimized " << optimized.instructionCount() << " instructions (" << optimized.temporaries()
+              << " temporaries), " << ms(middle, end) << " ms; results "
+              << (plainResults == optimizedResults ? "identical" : "DIFFER") << "\n";
+    bench::record("unoptimized ns/row", ms(start, middle) * 1e6 / rows);
+    bench::record("optimized ns/row", ms(middle, end) * 1e6 / rows);
+
+    // 100 distinct formulas, submitted 200000 times in random order.
+    std::vector<std::string> formulas;
+    for (int k = 0; k < 100; ++k) {
+        formulas.push_back("(x * y + " + std::to_string(k) + ") * (x - y) / (2 * 3 + " + std::to_string(k) + ")");
+    }
+    const std::size_t submissions = 200000;
+    std::vector<std::size_t> order(submissions);
+    for (std::size_t& pick : order) {
+        pick = static_cast<std::size_t>(rng.below(formulas.size()));
+    }
+    const double row[2] = {3.0, 4.0};
+    start = std::chrono::steady_clock::now();
+    double compiledSum = 0;
+    for (std::size_t pick : order) {
+        compiledSum += compileExpression(formulas[pick], {"x", "y"}).evaluate(row);
+    }
+    middle = std::chrono::steady_clock::now();
+    ProgramCache cache(128, {"x", "y"});
+    double cachedSum = 0;
+    for (std::size_t pick : order) {
+        cachedSum += cache.get(formulas[pick])->evaluate(row);
+    }
+    end = std::chrono::steady_clock::now();
+    std::cout << "Program cache: " << submissions << " submissions of " << formulas.size() << " formulas\n"
+              << "  compile every time " << ms(start, middle) << " ms, cached " << ms(middle, end) << " ms ("
+              << cache.hits() << " hits, " << cache.misses() << " misses; sums " << compiledSum << " / " << cachedSum
+              << ")\n";
+    bench::record("compile every time ns/submission", ms(start, middle) * 1e6 / submissions);
+    bench::record("cached ns/submission", ms(middle, end) * 1e6 / submissions);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("recursive_parser", argc, argv);
+        suite.run("compile", runCompileBenchmark);
+        suite.run("optimizer", runOptimizerBenchmark);
+        return suite.finish();
+    }
+#if defined(DSA_HAVE_MMAP)
+    if (argc > 2 && std::string(argv[1]) == "--file") {
+        // Streaming mode: evaluate every line of a memory-mapped file, reporting errors per line.
+        MappedText file(argv[2]);
+        ExpressionStream stream(file.view());
+        int failures = 0;
+        for (std::string_view line; stream.next(line);) {
+            try {
+                Lexer lexer(line);
+                Parser parser(lexer);
+                std::cout << parser.parseExpression() << "\n";
+            } catch (const std::exception& ex) {
+                std::cerr << "Line " << stream.lineNumber() << ": " << ex.what() << "\n";
+                ++failures;
+            }
+        }
+        return failures == 0 ? 0 : 1;
+    }
+#endif
+
     std::string input;
-    std::cout << "Enter an arithmetic expression (supports +, -, *, /, parentheses):\n";
+    std::cout << "Enter an arithmetic expression (supports +, -, *, /, parentheses, and variables):\n";
     std::getline(std::cin, input);
 
     try {
-        Lexer lexer(input);
-        Parser parser(lexer);
-        // parseExpression walks the grammar directly and returns the evaluated numeric result.
-        double result = parser.parseExpression();
-        std::cout << "Result: " << result << "\n";
+        Program program = compileExpression(input);
+        if (program.variableNames().empty()) {
+            Lexer lexer(input);
+            Parser parser(lexer);
+            // parseExpression walks the grammar directly and returns the evaluated numeric result.
+            double result = parser.parseExpression();
+            std::cout << "Result: " << result << "\n";
+        } else {
+            // Variables need values, so read one row of them and run the compiled program on it.
+            std::cout << "Enter values for";
+            for (const std::string& name : program.variableNames()) {
+                std::cout << ' ' << name;
+            }
+            std::cout << ":\n";
+            std::vector<double> row(program.variableNames().size());
+            for (double& value : row) {
+                if (!(std::cin >> value)) {
+                    throw std::runtime_error("Expected a numeric value for every variable");
+                }
+            }
+            std::cout << "Result: " << program.evaluate(row) << "\n";
+        }
     } catch (const std::exception& ex) {
         std::cerr << "Parsing error: " << ex.what() << "\n";
         return 1;
@@ -0,0 +1,25 @@
+#!/bin/sh
+# Builds every demo that has a --bench mode and writes one JSON report per program into a results
+# directory, so two directories from different releases can be diffed case by case.
+#
+#   ./run_benchmarks.sh [results-dir] [extra harness flags, e.g. --repeat 3 --filter lookup]
+#
+# Set COUNTERS=1 to build with -DDSA_COUNTERS and collect hot-path counters instead of clean timings.
+set -eu
+
+out=${1:-bench_results}
+[ $# -gt 0 ] && shift
+cxx=${CXX:-g++}
+flags="-std=c++17 -O2 -march=native -pthread"
+if [ "${COUNTERS:-0}" = 1 ]; then
+    flags="$flags -DDSA_COUNTERS"
+fi
+
+mkdir -p "$out"
+for source in binary_search bst_unique bst_with_duplicates combinations graph_traversal hash_map linked_list \
+              merge_sort min_max_heap permutations queue recursive_parser stack subsets; do
+    echo "== $source"
+    $cxx $flags "$source.cpp" -o "$out/$source"
+    (cd "$out" && "./$source" --bench --json "$source.json" "$@")
+    rm -f "$out/$source"
+done
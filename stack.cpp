@@ -1,6 +1,16 @@
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bench_harness.h"
 
 // This program implements a stack of integers backed by a dynamically resizing array.
 // Push operations double the underlying storage when full so that amortized cost stays O(1),
@@ -76,7 +86,203 @@ private:
     std::size_t topIndex = 0;
 };
 
-int main() {
+// Bounded lock-free LIFO stack (Treiber's algorithm). Values live in a node array allocated up front;
+// both the stack itself and the list of free nodes are singly linked lists of node indices whose head
+// is swapped in with a single compare-and-swap, so a push or pop never blocks another thread.
+//
+// A plain pointer CAS suffers from ABA: a thread reads head A and its successor B, stalls while other
+// threads pop A, pop B, and push A back, and then its CAS succeeds and installs the stale B. Each head
+// therefore packs a 32-bit node index with a 32-bit version tag that every successful update bumps,
+// so the stale CAS sees a different word and retries. (The tag would have to wrap all the way around
+// during one stalled thread's attempt to fool it.) Because nodes are recycled through the free list and
+// never freed, reading a node that was just popped by someone else is harmless.
+template <typename T>
+class LockFreeStack {
+public:
+    explicit LockFreeStack(std::size_t capacity) : nodes(capacity) {
+        if (capacity == 0 || capacity >= kNil) {
+            throw std::invalid_argument("LockFreeStack capacity must be between 1 and 2^32 - 2");
+        }
+        // Every node starts on the free list, chained in index order.
+        for (std::size_t i = 0; i < capacity; ++i) {
+            nodes[i].next.store(i + 1 < capacity ? static_cast<std::uint32_t>(i + 1) : kNil,
+                                std::memory_order_relaxed);
+        }
+        freeHead.store(0, std::memory_order_relaxed);
+    }
+
+    LockFreeStack(const LockFreeStack&) = delete;
+    LockFreeStack& operator=(const LockFreeStack&) = delete;
+
+    std::size_t capacity() const {
+        return nodes.size();
+    }
+
+    // Returns false when all nodes are in use.
+    bool tryPush(T value) {
+        std::uint32_t index = popIndex(freeHead);
+        if (index == kNil) {
+            return false;
+        }
+        nodes[index].value = std::move(value);
+        pushIndex(top, index);
+        return true;
+    }
+
+    // Returns false when the stack is empty.
+    bool tryPop(T& out) {
+        std::uint32_t index = popIndex(top);
+        if (index == kNil) {
+            return false;
+        }
+        out = std::move(nodes[index].value);
+        pushIndex(freeHead, index);
+        return true;
+    }
+
+private:
+    static constexpr std::uint32_t kNil = 0xFFFFFFFFu;
+
+    struct StackNode {
+        // Atomic because a thread that lost a race may still read it while the winner relinks the node.
+        std::atomic<std::uint32_t> next{kNil};
+        T value{};
+    };
+
+    static std::uint32_t indexOf(std::uint64_t head) {
+        return static_cast<std::uint32_t>(head);
+    }
+
+    static std::uint64_t tagged(std::uint64_t previous, std::uint32_t index) {
+        return (((previous >> 32) + 1) << 32) | index;
+    }
+
+    std::uint32_t popIndex(std::atomic<std::uint64_t>& head) {
+        std::uint64_t current = head.load(std::memory_order_acquire);
+        for (;;) {
+            std::uint32_t index = indexOf(current);
+            if (index == kNil) {
+                return kNil;
+            }
+            std::uint32_t next = nodes[index].next.load(std::memory_order_relaxed);
+            // Acquire on success pairs with the release that published the node (and its value).
+            if (head.compare_exchange_weak(current, tagged(current, next), std::memory_order_acquire,
+                                           std::memory_order_acquire)) {
+                return index;
+            }
+            DSA_COUNT("lock_free_stack.cas_retries", 1);
+        }
+    }
+
+    void pushIndex(std::atomic<std::uint64_t>& head, std::uint32_t index) {
+        std::uint64_t current = head.load(std::memory_order_relaxed);
+        for (;;) {
+            nodes[index].next.store(indexOf(current), std::memory_order_relaxed);
+            if (head.compare_exchange_weak(current, tagged(current, index), std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+                return;
+            }
+            DSA_COUNT("lock_free_stack.cas_retries", 1);
+        }
+    }
+
+    alignas(64) std::atomic<std::uint64_t> top{kNil};
+    alignas(64) std::atomic<std::uint64_t> freeHead{kNil};
+    alignas(64) std::vector<StackNode> nodes;
+};
+
+// Baseline for the benchmark: the array-backed Stack above behind a mutex, bounded like LockFreeStack.
+class LockedStack {
+public:
+    explicit LockedStack(std::size_t capacity) : limit(capacity), stack(capacity) {}
+
+    bool tryPush(int value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stack.size() == limit) {
+            return false;
+        }
+        stack.push(value);
+        return true;
+    }
+
+    bool tryPop(int& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stack.empty()) {
+            return false;
+        }
+        out = stack.pop();
+        return true;
+    }
+
+private:
+    std::size_t limit;
+    std::mutex mutex;
+    Stack stack;
+};
+
+// Each thread pushes a burst of values and pops the same number back, repeatedly, so pushes and pops
+// from all threads interleave on the shared top. Returns millions of operations per second and checks
+// that the values popped add up to the values pushed.
+template <typename Shared>
+double measureStack(std::size_t threadCount, std::size_t opsPerThread) {
+    const std::size_t burst = 64;
+    Shared stack(threadCount * burst);
+    std::atomic<long long> balance{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            long long local = 0;
+            int value;
+            for (std::size_t done = 0; done < opsPerThread; done += 2 * burst) {
+                for (std::size_t i = 0; i < burst; ++i) {
+                    int pushed = static_cast<int>(t * opsPerThread + done + i);
+                    while (!stack.tryPush(pushed)) {
+                        std::this_thread::yield();
+                    }
+                    local += pushed;
+                }
+                for (std::size_t i = 0; i < burst; ++i) {
+                    // Another thread may have taken what we pushed; keep trying until we get a value.
+                    while (!stack.tryPop(value)) {
+                        std::this_thread::yield();
+                    }
+                    local -= value;
+                }
+            }
+            balance.fetch_add(local);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (balance.load() != 0) {
+        throw std::logic_error("Stack lost or duplicated values");
+    }
+    return static_cast<double>(threadCount * opsPerThread) /
+           std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+void runStackBenchmark() {
+    const std::size_t ops = 1 << 23;
+    std::cout << "Stack benchmark (M ops/s, " << std::thread::hardware_concurrency() << " hardware threads)\n";
+    for (std::size_t threads : {1, 2, 4, 8}) {
+        double lockFree = measureStack<LockFreeStack<int>>(threads, ops / threads);
+        double locked = measureStack<LockedStack>(threads, ops / threads);
+        std::cout << "  " << threads << " threads: LockFreeStack " << lockFree << ", LockedStack " << locked << "\n";
+        bench::record("LockFreeStack " + std::to_string(threads) + " threads Mops/s", lockFree);
+        bench::record("LockedStack " + std::to_string(threads) + " threads Mops/s", locked);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("stack", argc, argv);
+        suite.run("stack", runStackBenchmark);
+        return suite.finish();
+    }
+
     Stack stack;
 
     for (int value : {3, 7, 11, 15}) {
@@ -98,5 +304,15 @@ int main() {
         std::cout << "Exception caught: " << ex.what() << "\n";
     }
 
+    // The lock-free variant is bounded and reports full or empty instead of growing or throwing.
+    LockFreeStack<int> shared(3);
+    for (int value : {3, 7, 11, 15}) {
+        std::cout << "LockFreeStack push " << value << (shared.tryPush(value) ? " ok" : " rejected (full)") << "\n";
+    }
+    int popped;
+    while (shared.tryPop(popped)) {
+        std::cout << "LockFreeStack popped " << popped << "\n";
+    }
+
     return 0;
 }
@@ -1,6 +1,19 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "bench_harness.h"
+#include "thread_slices.h"
+
 // This program enumerates all subsets (the power set) of a small collection of integers.
 // The algorithm uses recursion to decide for each position whether to include the element.
 // This approach is effectively walking a binary decision tree of height n, yielding 2^n subsets.
@@ -28,12 +41,220 @@ void generateSubsets(const std::vector<int>& items, size_t index, std::vector<in
     generateSubsets(items, index + 1, current);
 }
 
-int main() {
+// Lazily enumerates a slice of the 2^n subsets of items[0..n) (n <= 63) in reflected Gray-code order.
+// Subset number r is the bitmask r ^ (r >> 1). Consecutive subsets differ by exactly one element: going
+// from r - 1 to r toggles the bit at the lowest set bit of r. That makes each step O(1), and callers see
+// which element was added or removed (changedItem/added), so an incremental score like a running sum
+// can be updated in place instead of being recomputed over the whole subset.
+//
+// The members are kept in the caller's out[0..n) buffer, in no particular order. A removed element's
+// slot is filled with the last member, and two fixed inline index tables find both slots in O(1),
+// so nothing is allocated. Unranking is free: the generator simply starts at the Gray code of `first`,
+// and separate threads can take disjoint slices of the 2^n space.
+class GraySubsetGenerator {
+public:
+    static constexpr std::size_t kMaxItems = 63;
+
+    GraySubsetGenerator(const int* items, std::size_t n, int* out, std::uint64_t first = 0,
+                        std::uint64_t count = std::numeric_limits<std::uint64_t>::max())
+        : items(items), out(out) {
+        if (n > kMaxItems) {
+            throw std::invalid_argument("GraySubsetGenerator supports at most 63 items");
+        }
+        std::uint64_t total = std::uint64_t(1) << n;
+        remaining = first < total ? std::min(count, total - first) : 0;
+        rank = first;
+        std::uint64_t start = first ^ (first >> 1);
+        for (std::size_t item = 0; item < n; ++item) {
+            if (start >> item & 1) {
+                add(item);
+            }
+        }
+    }
+
+    // Advances to the next subset of the slice; returns false once the slice is exhausted.
+    bool next() {
+        if (remaining == 0) {
+            return false;
+        }
+        --remaining;
+        if (!started) {
+            started = true;
+            return true;
+        }
+        ++rank;
+        changed = static_cast<std::size_t>(lowestSetBit(rank));
+        if (mask >> changed & 1) {
+            remove(changed);
+        } else {
+            add(changed);
+        }
+        return true;
+    }
+
+    const int* members() const {
+        return out;
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    // Bit i is set when items[i] is in the current subset.
+    std::uint64_t bits() const {
+        return mask;
+    }
+
+    // The item toggled by the last step and whether it was added; meaningless before the second next().
+    int changedItem() const {
+        return items[changed];
+    }
+
+    bool added() const {
+        return mask >> changed & 1;
+    }
+
+private:
+    const int* items;
+    int* out;
+    std::uint64_t remaining;
+    std::uint64_t rank;
+    std::uint64_t mask = 0;
+    std::size_t count = 0;
+    std::size_t changed = 0;
+    bool started = false;
+    // slotOf[i] is where items[i] sits in out while it is a member; itemAt inverts it.
+    std::array<std::uint8_t, kMaxItems> slotOf{};
+    std::array<std::uint8_t, kMaxItems> itemAt{};
+
+    static int lowestSetBit(std::uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(value);
+#else
+        int bit = 0;
+        while (!(value >> bit & 1)) {
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    void add(std::size_t item) {
+        mask |= std::uint64_t(1) << item;
+        slotOf[item] = static_cast<std::uint8_t>(count);
+        itemAt[count] = static_cast<std::uint8_t>(item);
+        out[count++] = items[item];
+    }
+
+    void remove(std::size_t item) {
+        mask &= ~(std::uint64_t(1) << item);
+        std::size_t slot = slotOf[item];
+        std::size_t last = itemAt[--count];
+        // The last member moves into the hole; swapping it (even with itself) keeps both tables exact.
+        out[slot] = out[count];
+        itemAt[slot] = static_cast<std::uint8_t>(last);
+        slotOf[last] = static_cast<std::uint8_t>(slot);
+    }
+};
+
+// Counts the subsets of items whose elements sum to target, across threads. Each thread walks its own
+// Gray-code slice and keeps the running sum up to date from the one element each step toggles. The item
+// count is checked first: past 63 items 2^n does not fit in the 64-bit slice range at all.
+inline std::uint64_t countSubsetSums(const std::vector<int>& items, long long target, unsigned threads) {
+    if (items.size() > GraySubsetGenerator::kMaxItems) {
+        throw std::invalid_argument("countSubsetSums supports at most 63 items");
+    }
+    std::vector<PaddedCounter> matches(std::max(1u, threads));
+    forEachSlice(std::uint64_t(1) << items.size(), threads, [&](std::uint64_t first, std::uint64_t count, unsigned t) {
+        std::array<int, GraySubsetGenerator::kMaxItems> buffer;
+        GraySubsetGenerator generator(items.data(), items.size(), buffer.data(), first, count);
+        long long sum = 0;
+        bool seeded = false;
+        std::uint64_t found = 0;
+        while (generator.next()) {
+            if (!seeded) {
+                // The slice starts mid-sequence; sum its first subset once, then update per step.
+                for (std::size_t i = 0; i < generator.size(); ++i) {
+                    sum += generator.members()[i];
+                }
+                seeded = true;
+            } else {
+                sum += generator.added() ? generator.changedItem() : -generator.changedItem();
+            }
+            found += sum == target ? 1 : 0;
+        }
+        matches[t].value = found;
+    });
+    std::uint64_t total = 0;
+    for (const PaddedCounter& tally : matches) {
+        total += tally.value;
+    }
+    return total;
+}
+
+// Counts subset sums over 2^24 subsets: Gray-code enumeration on one and several threads against the
+// recursive include/exclude enumeration, which re-sums each finished subset.
+void runSubsetBenchmark() {
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::vector<int> items(24);
+    std::iota(items.begin(), items.end(), 1);
+    const long long target = 150;
+    std::cout << "Subset benchmark: subsets of 1.." << items.size() << " summing to " << target << "\n";
+    for (unsigned threads : {1u, 2u, 4u}) {
+        auto start = std::chrono::steady_clock::now();
+        std::uint64_t found = countSubsetSums(items, target, threads);
+        auto end = std::chrono::steady_clock::now();
+        std::cout << "  Gray code, " << threads << " threads " << ms(start, end) << " ms (" << found << " subsets)\n";
+        bench::record("gray " + std::to_string(threads) + " threads ms", ms(start, end));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t found = 0;
+    std::vector<int> current;
+    std::function<void(std::size_t)> recurse = [&](std::size_t index) {
+        if (index == items.size()) {
+            long long sum = 0;
+            for (int value : current) {
+                sum += value;
+            }
+            found += sum == target ? 1 : 0;
+            return;
+        }
+        current.push_back(items[index]);
+        recurse(index + 1);
+        current.pop_back();
+        recurse(index + 1);
+    };
+    recurse(0);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "  recursive backtracking " << ms(start, end) << " ms (" << found << " subsets)\n";
+    bench::record("recursive ms", ms(start, end));
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench::Suite suite("subsets", argc, argv);
+        suite.run("subsets", runSubsetBenchmark);
+        return suite.finish();
+    }
+
     std::vector<int> values = {1, 2, 3};
     std::vector<int> current;
 
     // Kick off the recursion with no selections; current is mutated in place as branches explore sets.
     generateSubsets(values, 0, current);
 
+    // Gray-code order changes one element per step, reported as it happens.
+    int buffer[3];
+    std::cout << "Gray-code order:";
+    for (GraySubsetGenerator generator(values.data(), values.size(), buffer); generator.next();) {
+        std::cout << " {";
+        for (std::size_t i = 0; i < generator.size(); ++i) {
+            std::cout << (i ? "," : "") << generator.members()[i];
+        }
+        std::cout << '}';
+    }
+    std::cout << "\n";
+
     return 0;
 }
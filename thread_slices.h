@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Helpers shared by the parallel enumerations (permutations, combinations, subsets), which all split a
+// ranked space into one contiguous slice per thread and keep one running total per thread.
+
+// One cache line per thread's running total, so threads updating neighbouring entries do not falsely
+// share them.
+struct alignas(64) PaddedCounter {
+    std::uint64_t value = 0;
+};
+
+// Splits [0, total) into one contiguous slice per thread and runs body(first, count, thread) on each.
+// An exception escaping a thread would call std::terminate, so each worker parks its exception and the
+// first one (by thread index) is rethrown on the calling thread once every worker has joined.
+template <typename Body>
+void forEachSlice(std::uint64_t total, unsigned threads, Body body) {
+    threads = std::max(1u, threads);
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        std::uint64_t first = total / threads * t + std::min<std::uint64_t>(t, total % threads);
+        std::uint64_t count = total / threads + (t < total % threads ? 1 : 0);
+        workers.emplace_back([&body, &errors, first, count, t]() {
+            try {
+                body(first, count, t);
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}